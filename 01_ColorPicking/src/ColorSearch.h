@@ -0,0 +1,312 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "FrameRegion.h"
+#include "Poco/Event.h"
+
+// searches an image for a color on its own thread, so dragging the mouse never stalls drawing
+// only the latest search matters: if the color changes again before a search starts,
+// the older one is skipped
+//
+// the pixels are sorted into buckets of similar color when the image is loaded
+// (32 levels of red, green & blue), so a search only looks at the buckets near the color:
+// buckets completely inside the threshold match without checking, buckets completely
+// outside are skipped, and only the pixels in the buckets on the edge are checked one by one
+// only the pixels in the region are kept (see FrameRegion), the areas that are left out aren't
+// even put in the buckets, & the map is only as big as the region
+
+class ColorSearch : public ofThread {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ColorSearch(){
+
+		requestNum = 0;
+		resultNum = 0;
+		lastResultTaken = 0;
+	}
+
+	~ColorSearch(){
+
+		stop();
+	}
+
+	//--------------------------------------------------------------
+
+	// keep a copy of the region of the image, sort its pixels into buckets & start the thread
+
+	void setup(ofPixels & pixels, FrameRegion & frameRegion){
+
+		region = frameRegion;
+		region.setup(pixels.getWidth(), pixels.getHeight());
+		region.crop(pixels, source);
+		buildIndex();
+
+		// the map is only used on the search thread, so it can't have a texture
+		map.setUseTexture(false);
+		map.allocate(source.getWidth(), source.getHeight());
+
+		startThread(false, false);
+	}
+
+	//--------------------------------------------------------------
+
+	void stop(){
+
+		if( isThreadRunning() ){
+
+			stopThread();
+			newRequest.set();
+			waitForThread(false);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// ask for a search, this replaces any search that's waiting
+
+	void search(ofColor color, int threshold){
+
+		ofScopedLock lock(mutex);
+
+		requestColor = color;
+		requestThreshold = threshold;
+		requestNum++;
+
+		newRequest.set();
+	}
+
+	//--------------------------------------------------------------
+
+	// get the map (of the region) & shapes (in the image) from the latest search
+	// returns false if there's nothing new since the last time
+
+	bool getResult(ofPixels & mapPixels, vector<ofxCvBlob> & shapes){
+
+		ofScopedLock lock(mutex);
+
+		if( resultNum == lastResultTaken ) return false;
+
+		lastResultTaken = resultNum;
+		mapPixels = resultPixels;
+		shapes = resultShapes;
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// are we still catching up with the latest search?
+
+	bool isSearching(){
+
+		ofScopedLock lock(mutex);
+
+		return resultNum != requestNum;
+	}
+
+	//--------------------------------------------------------------
+
+	void threadedFunction(){
+
+		while( isThreadRunning() ){
+
+			// wait for a search (waking up now and then to see if we've been stopped)
+			if( !newRequest.tryWait(100) ) continue;
+
+			// take the latest search
+			mutex.lock();
+			ofColor color = requestColor;
+			int threshold = requestThreshold;
+			int num = requestNum;
+			mutex.unlock();
+
+			if( num == resultNum ) continue;
+
+			findMatchingPixels(color, threshold);
+
+			contourFinder.findContours(map, 5, source.getWidth() * 2 * source.getHeight(), 20000, true, false);
+
+			// move the shapes back to where they are in the image
+			vector<ofxCvBlob> shapes = contourFinder.blobs;
+
+			for(int i=0; i<shapes.size(); i++){
+
+				region.moveToFrame(shapes[i]);
+			}
+
+			// hand over the results
+			mutex.lock();
+			resultPixels.setFromPixels(map.getPixels(), map.getWidth(), map.getHeight(), 1);
+			resultShapes.swap(shapes);
+			resultNum = num;
+			mutex.unlock();
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// sort every pixel into a bucket by its color
+	// the pixels in a bucket are stored one after another, starting at bucketStarts[bucket]
+
+	void buildIndex(){
+
+		unsigned char * pix = source.getPixels();
+		int numPix = source.getWidth() * source.getHeight();
+		int channels = source.getNumChannels();
+
+		// count the pixels in each bucket
+		bucketStarts.assign(numBuckets + 1, 0);
+
+		for(int i=0; i<numPix; i++){
+
+			if( !region.isMasked(i) ) bucketStarts[getBucket(pix + i * channels) + 1]++;
+		}
+
+		for(int i=0; i<numBuckets; i++){
+
+			bucketStarts[i+1] += bucketStarts[i];
+		}
+
+		// then fill them in
+		vector<int> fill(bucketStarts.begin(), bucketStarts.end() - 1);
+		bucketPixels.resize(bucketStarts[numBuckets]);
+
+		for(int i=0; i<numPix; i++){
+
+			if( !region.isMasked(i) ) bucketPixels[fill[getBucket(pix + i * channels)]++] = i;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	int getBucket(unsigned char * color){
+
+		int shift = 8 - bucketBits;
+
+		return ((color[0] >> shift) << (bucketBits * 2)) | ((color[1] >> shift) << bucketBits) | (color[2] >> shift);
+	}
+
+	//--------------------------------------------------------------
+
+	// make a map of the pixels that are close to the color
+	// (the squared distance has to be less than the threshold cubed, same as the tracking apps)
+
+	void findMatchingPixels(ofColor & color, int thresh){
+
+		unsigned char * pix = source.getPixels();
+		unsigned char * mapPix = map.getPixels();
+		int channels = source.getNumChannels();
+		int minDist = thresh * thresh * thresh;
+
+		memset(mapPix, 0, map.getWidth() * map.getHeight());
+
+		// only the buckets within the distance of the color on each channel can match
+		int levels = 1 << bucketBits;
+		int bucketSize = 256 / levels;
+		int radius = ceil(sqrt((float)minDist));
+
+		int c[3] = { color.r, color.g, color.b };
+		int first[3], last[3];
+
+		for(int k=0; k<3; k++){
+
+			first[k] = MAX(0, c[k] - radius) / bucketSize;
+			last[k] = MIN(255, c[k] + radius) / bucketSize;
+		}
+
+		for(int r=first[0]; r<=last[0]; r++){
+			for(int g=first[1]; g<=last[1]; g++){
+				for(int b=first[2]; b<=last[2]; b++){
+
+					// the closest & furthest the bucket's colors can be from the color
+					int q[3] = { r, g, b };
+					int nearDist = 0;
+					int farDist = 0;
+
+					for(int k=0; k<3; k++){
+
+						int low = q[k] * bucketSize;
+						int high = low + bucketSize - 1;
+
+						int nearDiff = MAX(0, MAX(low - c[k], c[k] - high));
+						int farDiff = MAX(abs(c[k] - low), abs(c[k] - high));
+
+						nearDist += nearDiff * nearDiff;
+						farDist += farDiff * farDiff;
+					}
+
+					if( nearDist >= minDist ) continue;
+
+					int bucket = (r << (bucketBits * 2)) | (g << bucketBits) | b;
+					int start = bucketStarts[bucket];
+					int end = bucketStarts[bucket + 1];
+
+					if( farDist < minDist ){
+
+						// every pixel in the bucket matches
+						for(int i=start; i<end; i++){
+
+							mapPix[bucketPixels[i]] = 255;
+						}
+
+					} else {
+
+						// check each pixel
+						for(int i=start; i<end; i++){
+
+							unsigned char * p = pix + bucketPixels[i] * channels;
+
+							int diffR = c[0] - p[0];
+							int diffG = c[1] - p[1];
+							int diffB = c[2] - p[2];
+
+							if( ( diffR * diffR ) + ( diffG * diffG ) + ( diffB * diffB ) < minDist ){
+
+								mapPix[bucketPixels[i]] = 255;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		map.setFromPixels(mapPix, map.getWidth(), map.getHeight());
+
+		// do a little blurring & thresholding to smooth out the edges
+		map.blur(5);
+		map.threshold(128);
+
+		// the blur can spread into the areas that are left out
+		region.applyMask(map);
+	}
+
+	static const int bucketBits = 5;
+	static const int numBuckets = 1 << (bucketBits * 3);
+
+	ofPixels source; // only the region
+	FrameRegion region;
+
+	// the pixels sorted by color (these don't change after setup)
+	vector<int> bucketStarts;
+	vector<int> bucketPixels;
+
+	// only used by the search thread
+	ofxCvGrayscaleImage map;
+	ofxCvContourFinder contourFinder;
+
+	// shared between the threads (use the mutex)
+	Poco::Event newRequest;
+	ofColor requestColor;
+	int requestThreshold;
+	int requestNum;
+
+	ofPixels resultPixels;
+	vector<ofxCvBlob> resultShapes;
+	int resultNum;
+	int lastResultTaken;
+};
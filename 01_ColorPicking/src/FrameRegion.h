@@ -0,0 +1,404 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxXmlSettings.h"
+#include "ofxOpenCv.h"
+
+// the part of a frame to look for shapes in
+// a rect (the region of interest) with some areas left out (burnt-in subtitles, a logo, a timecode),
+// cut down to the picture if the movie is letterboxed or pillarboxed
+// the maps are only as big as the part that's looked at, so nothing outside it is ever touched,
+// & the shapes are moved back to where they are in the frame
+//
+// the settings are read from a region tag (in region.xml, or in a batch item):
+//
+// <region>
+//   <x>0</x> <y>0</y> <width>640</width> <height>360</height>   (leave these out for the whole frame)
+//   <exclude> <x>0</x> <y>300</y> <width>640</width> <height>60</height> </exclude>
+//   <mask>mask.png</mask>   (the size of the frame, black pixels are left out)
+//   <findBars>1</findBars>   (find black bars from frames spread across the movie & leave them out)
+// </region>
+
+class FrameRegion {
+
+public:
+
+	//--------------------------------------------------------------
+
+	FrameRegion(){
+
+		bFindBars = false;
+		barSamples = 20;
+		barThreshold = 32;
+		numBarSamples = 0;
+		bBarsFound = false;
+
+		frameWidth = frameHeight = 0;
+		x = y = width = height = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	void loadSettings(ofxXmlSettings & xmlDoc){
+
+		if( !xmlDoc.tagExists("region") ) return;
+
+		xmlDoc.pushTag("region");
+
+		roi.set(xmlDoc.getValue("x", 0), xmlDoc.getValue("y", 0), xmlDoc.getValue("width", 0), xmlDoc.getValue("height", 0));
+
+		exclusions.clear();
+
+		for(int i=0; i<xmlDoc.getNumTags("exclude"); i++){
+
+			xmlDoc.pushTag("exclude", i);
+			exclusions.push_back( ofRectangle(xmlDoc.getValue("x", 0), xmlDoc.getValue("y", 0), xmlDoc.getValue("width", 0), xmlDoc.getValue("height", 0)) );
+			xmlDoc.popTag();
+		}
+
+		maskPath = xmlDoc.getValue("mask", "");
+		maskPixels.clear();
+
+		if( maskPath != "" ){
+
+			ofImage maskImage;
+			maskImage.setUseTexture(false);
+
+			if( maskImage.loadImage(maskPath) ){
+
+				maskImage.setImageType(OF_IMAGE_GRAYSCALE);
+				maskPixels = maskImage.getPixelsRef();
+
+			} else {
+
+				ofLog(OF_LOG_ERROR, "Failed to load mask " + maskPath);
+			}
+		}
+
+		// any bars that were found were for another movie
+		clearBarSamples();
+		bFindBars = xmlDoc.getValue("findBars", 0) != 0;
+		barSamples = MAX(1, xmlDoc.getValue("barSamples", barSamples));
+		barThreshold = xmlDoc.getValue("barThreshold", barThreshold);
+
+		xmlDoc.popTag();
+	}
+
+	//--------------------------------------------------------------
+
+	// find the black bars from frames spread across a movie
+	// (a pixel is part of the picture if any channel is brighter than barThreshold, the bars are
+	// the rows & columns at the edges where hardly any pixel ever is)
+
+	void findBars(ofVideoPlayer & movie){
+
+		clearBarSamples();
+
+		int numFrames = movie.getTotalNumFrames();
+
+		for(int i=0; i<barSamples; i++){
+
+			movie.setFrame(i * numFrames / barSamples);
+			movie.update();
+
+			addBarSample(movie.getPixelsRef());
+		}
+
+		findBarsFromSamples();
+	}
+
+	//--------------------------------------------------------------
+
+	void clearBarSamples(){
+
+		rowCounts.clear();
+		columnCounts.clear();
+		numBarSamples = 0;
+		bBarsFound = false;
+	}
+
+	void addBarSample(ofPixels & pixels){
+
+		int w = pixels.getWidth();
+		int h = pixels.getHeight();
+		int channels = pixels.getNumChannels();
+		unsigned char * pix = pixels.getPixels();
+
+		// a frame of another size starts again
+		if( rowCounts.size() != h || columnCounts.size() != w ){
+
+			rowCounts.assign(h, 0);
+			columnCounts.assign(w, 0);
+			numBarSamples = 0;
+		}
+
+		numBarSamples++;
+
+		for(int j=0; j<h; j++){
+
+			for(int i=0; i<w; i++){
+
+				unsigned char * p = pix + (j * w + i) * channels;
+				int brightest = p[0];
+
+				for(int c=1; c<MIN(channels, 3); c++){
+
+					brightest = MAX(brightest, p[c]);
+				}
+
+				if( brightest > barThreshold ){
+
+					rowCounts[j]++;
+					columnCounts[i]++;
+				}
+			}
+		}
+	}
+
+	void findBarsFromSamples(){
+
+		int w = columnCounts.size();
+		int h = rowCounts.size();
+
+		// a row or column is in the picture if at least 1% of it is (over all of the samples)
+		int minRowCount = MAX(1, w * numBarSamples / 100);
+		int minColumnCount = MAX(1, h * numBarSamples / 100);
+
+		int top = 0, bottom = h - 1, left = 0, right = w - 1;
+
+		while( top < h && rowCounts[top] < minRowCount ) top++;
+		while( bottom > top && rowCounts[bottom] < minRowCount ) bottom--;
+		while( left < w && columnCounts[left] < minColumnCount ) left++;
+		while( right > left && columnCounts[right] < minColumnCount ) right--;
+
+		// if it's all black there's nothing to go on
+		bBarsFound = ( top < h && left < w );
+
+		if( bBarsFound ){
+
+			picture.set(left, top, right - left + 1, bottom - top + 1);
+
+			if( picture.width < w || picture.height < h ){
+
+				ofLogNotice("Found black bars, the picture is " + ofToString((int)picture.width) + " x " + ofToString((int)picture.height) + " at " + ofToString(left) + ", " + ofToString(top));
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// work out the part of the frame that's looked at & the mask for it
+
+	void setup(int w, int h){
+
+		frameWidth = w;
+		frameHeight = h;
+
+		int left = 0, top = 0, right = w, bottom = h;
+
+		if( roi.width > 0 && roi.height > 0 ){
+
+			left = MAX(left, (int)roi.x);
+			top = MAX(top, (int)roi.y);
+			right = MIN(right, (int)(roi.x + roi.width));
+			bottom = MIN(bottom, (int)(roi.y + roi.height));
+		}
+
+		if( bBarsFound ){
+
+			left = MAX(left, (int)picture.x);
+			top = MAX(top, (int)picture.y);
+			right = MIN(right, (int)(picture.x + picture.width));
+			bottom = MIN(bottom, (int)(picture.y + picture.height));
+		}
+
+		if( right <= left || bottom <= top ){
+
+			ofLog(OF_LOG_WARNING, "The region is outside the frame, using the whole frame");
+			left = top = 0;
+			right = w;
+			bottom = h;
+		}
+
+		x = left;
+		y = top;
+		width = right - left;
+		height = bottom - top;
+
+		// only keep a mask if something's left out
+		mask.clear();
+
+		if( exclusions.size() == 0 && !maskPixels.isAllocated() ) return;
+
+		mask.assign(width * height, 255);
+
+		for(int e=0; e<exclusions.size(); e++){
+
+			int exLeft = MAX(x, (int)exclusions[e].x);
+			int exTop = MAX(y, (int)exclusions[e].y);
+			int exRight = MIN(x + width, (int)(exclusions[e].x + exclusions[e].width));
+			int exBottom = MIN(y + height, (int)(exclusions[e].y + exclusions[e].height));
+
+			for(int j=exTop; j<exBottom; j++){
+
+				for(int i=exLeft; i<exRight; i++){
+
+					mask[(j - y) * width + (i - x)] = 0;
+				}
+			}
+		}
+
+		if( maskPixels.isAllocated() ){
+
+			if( maskPixels.getWidth() != w || maskPixels.getHeight() != h ){
+
+				ofLog(OF_LOG_WARNING, "The mask " + maskPath + " isn't the size of the frame, ignoring it");
+
+			} else {
+
+				unsigned char * maskPix = maskPixels.getPixels();
+
+				for(int j=0; j<height; j++){
+
+					for(int i=0; i<width; i++){
+
+						if( maskPix[(j + y) * w + (i + x)] < 128 ) mask[j * width + i] = 0;
+					}
+				}
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	bool isWholeFrame(){
+
+		return x == 0 && y == 0 && width == frameWidth && height == frameHeight;
+	}
+
+	//--------------------------------------------------------------
+
+	// copy the part of a frame that's looked at
+
+	void crop(ofPixels & pixels, ofPixels & cropped){
+
+		int channels = pixels.getNumChannels();
+
+		cropped.allocate(width, height, channels);
+
+		unsigned char * pix = pixels.getPixels();
+		unsigned char * croppedPix = cropped.getPixels();
+
+		for(int j=0; j<height; j++){
+
+			memcpy(croppedPix + j * width * channels, pix + ((j + y) * pixels.getWidth() + x) * channels, width * channels);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// black out the areas that are left out of a map (it's the size of the region)
+
+	void applyMask(ofxCvGrayscaleImage & map){
+
+		if( mask.size() == 0 ) return;
+
+		unsigned char * mapPix = map.getPixels();
+
+		for(int i=0; i<mask.size(); i++){
+
+			mapPix[i] &= mask[i];
+		}
+
+		map.setFromPixels(mapPix, width, height);
+	}
+
+	bool isMasked(int i){
+
+		return mask.size() > 0 && mask[i] == 0;
+	}
+
+	//--------------------------------------------------------------
+
+	// move a shape found in a map back to where it is in the frame
+
+	void moveToFrame(ofxCvBlob & shape){
+
+		for(int i=0; i<shape.pts.size(); i++){
+
+			shape.pts[i].x += x;
+			shape.pts[i].y += y;
+		}
+
+		shape.boundingRect.x += x;
+		shape.boundingRect.y += y;
+		shape.centroid.x += x;
+		shape.centroid.y += y;
+	}
+
+	//--------------------------------------------------------------
+
+	// add the settings to a cache key (nothing is added for the whole frame, so the keys stay the same)
+
+	template <class Key>
+	void addToKey(Key & key){
+
+		if( roi.width > 0 && roi.height > 0 ){
+
+			key.addValue(1);
+			key.addValue(roi.x);
+			key.addValue(roi.y);
+			key.addValue(roi.width);
+			key.addValue(roi.height);
+		}
+
+		for(int i=0; i<exclusions.size(); i++){
+
+			key.addValue(2);
+			key.addValue(exclusions[i].x);
+			key.addValue(exclusions[i].y);
+			key.addValue(exclusions[i].width);
+			key.addValue(exclusions[i].height);
+		}
+
+		if( maskPath != "" ){
+
+			key.addValue(3);
+			key.addFile(maskPath);
+		}
+
+		// the bars are found the same way every time, so the settings are enough
+		if( bFindBars ){
+
+			key.addValue(4);
+			key.addValue(barSamples);
+			key.addValue(barThreshold);
+		}
+	}
+
+	// the settings
+	ofRectangle roi; // an empty rect for the whole frame
+	vector<ofRectangle> exclusions;
+	string maskPath;
+	ofPixels maskPixels;
+	bool bFindBars;
+	int barSamples;
+	int barThreshold;
+
+	// the picture inside the black bars (see findBars)
+	vector<int> rowCounts;
+	vector<int> columnCounts;
+	int numBarSamples;
+	ofRectangle picture;
+	bool bBarsFound;
+
+	// the part of the frame that's looked at (see setup)
+	int frameWidth;
+	int frameHeight;
+	int x;
+	int y;
+	int width;
+	int height;
+	vector<unsigned char> mask; // 0 where it's left out, empty if nothing is
+};
@@ -10,20 +10,45 @@ void testApp::setup(){
 	// load the path
 	source.loadImage("Robocop01.png");
 	
-	// create a CV "map" to show the areas of matching color
-	colorMap.allocate(source.getWidth(), source.getHeight());
+	// only look at part of the image, if region.xml says so (see FrameRegion)
+	// & leave out the black bars if it's a letterboxed still
+	ofxXmlSettings regionXml;
+	
+	if( regionXml.loadFile("region.xml") ) region.loadSettings(regionXml);
+	
+	if( region.bFindBars ){
+		
+		region.addBarSample(source.getPixelsRef());
+		region.findBarsFromSamples();
+	}
+	
+	region.setup(source.getWidth(), source.getHeight());
+	
+	// create a CV "map" to show the areas of matching color (only as big as the region)
+	colorMap.allocate(region.width, region.height);
 	
 	// create a window as big as the image
 	ofSetWindowShape(source.getWidth()*2, source.getHeight());
 	
 	// how close should the color be to the picked color
 	matchThreshold = 20;
+	bColorPicked = false;
+	
+	// the searching happens on another thread, so the picking stays smooth
+	colorSearch.setup(source.getPixelsRef(), region);
 }
 
 //--------------------------------------------------------------
 
 void testApp::update(){
-
+	
+	// show the latest search results
+	ofPixels mapPixels;
+	
+	if( colorSearch.getResult(mapPixels, shapes) ){
+		
+		colorMap.setFromPixels(mapPixels.getPixels(), colorMap.getWidth(), colorMap.getHeight());
+	}
 }
 
 //--------------------------------------------------------------
@@ -50,14 +75,23 @@ void testApp::draw(){
 	// draw the map
 	// the white pixels indicate matching colors
 	ofSetColor(255, 255, 255);
-	colorMap.draw(ofGetWidth()/2, 0);
+	colorMap.draw(ofGetWidth()/2 + region.x, region.y);
 	
 	// draw the blobs found in the open cv search
-	contourFinder.draw(ofGetWidth()/2, 0);
+	for(int i=0; i<shapes.size(); i++){
+		
+		shapes[i].draw(ofGetWidth()/2, 0);
+	}
 	
 	ofSetColor(0, 255, 255);
-	ofDrawBitmapString("There are "+ofToString(contourFinder.nBlobs)+" shapes", ofGetWidth()/2+20, 20);
+	ofDrawBitmapString("There are "+ofToString(shapes.size())+" shapes", ofGetWidth()/2+20, 20);
 	ofDrawBitmapString("Press 's' to save the shapes", ofGetWidth()/2+20, 40);
+	ofDrawBitmapString("Threshold "+ofToString(matchThreshold)+" (press '+' or '-' to change)", ofGetWidth()/2+20, 60);
+	
+	if( colorSearch.isSearching() ){
+		
+		ofDrawBitmapString("Searching...", ofGetWidth()/2+20, 80);
+	}
 }
 
 //--------------------------------------------------------------
@@ -87,59 +121,17 @@ ofColor testApp::getColorAtPos(ofPixels & pixels, int x, int y){
 
 //--------------------------------------------------------------
 
-// get all of similar colors in an image
+// pick the color under the mouse & search for it
 
-void testApp::searchForColorInPixels(ofColor & color, ofPixels & pixels, int thresh){
-	
-	unsigned char * pix = pixels.getPixels();
-	unsigned char * mapPix = colorMap.getPixels();
-	int numPix = pixels.getWidth() * pixels.getHeight();
-	int channels = pixels.getNumChannels();
-	int minDist = thresh * thresh * thresh;
-	
-	for(int i=0; i<numPix; i++){
-	
-		int posInMem = i * channels;
-		int dstInMem = i;
-	
-		unsigned char r = pix[posInMem]; 
-		unsigned char g = pix[posInMem+1]; 
-		unsigned char b = pix[posInMem+2]; 
-		
-		int diffR = color.r - r;
-		int diffG = color.g - g; 
-		int diffB = color.b - b; 
-		
-		float dist = ( diffR * diffR ) + ( diffG * diffG ) + ( diffB * diffB );
-		
-		if( dist < minDist ){
-			
-			mapPix[dstInMem] = 255;
-			
-		} else {
-			
-			mapPix[dstInMem] = 0;
-		}
-	}
-	
-	// update the pixels
-	colorMap.setFromPixels(mapPix, colorMap.getWidth(), colorMap.getHeight());
-	colorMap.updateTexture();
+void testApp::pickColor(int x, int y){
 	
-	// do a little blurring & thresholding to smooth out the edges
-	colorMap.blur(5);
-	colorMap.threshold(128);
-}
-
-//--------------------------------------------------------------
-
-// use opencv's contour finder to get the outlines from a greyscale image
-
-void testApp::convertToVectors(ofxCvGrayscaleImage & map){
-
-	contourFinder.findContours(map, 5, ofGetWidth() * ofGetHeight(), 20000, true, false);
+	// get the color
+	pickedColor = getColorAtPos(source.getPixelsRef(), x, y);
+	bColorPicked = true;
 	
-	//printf("there are %i contours\n", contourFinder.nBlobs);
+	// search for similar colors within the image & get the vector outlines from the matching areas
+	// (the search thread only does the latest search, so dragging quickly skips the ones in between)
+	colorSearch.search(pickedColor, matchThreshold);
 }
 
 //--------------------------------------------------------------
@@ -153,7 +145,7 @@ void testApp::saveShapeDataAsXml(string filePath){
 	xmlDoc.addTag("shapes");
 	xmlDoc.pushTag("shapes");
 	
-	int numShapes = contourFinder.nBlobs;
+	int numShapes = shapes.size();
 	
 	for(int i=0; i<numShapes; i++){
 	
@@ -171,14 +163,14 @@ void testApp::saveShapeDataAsXml(string filePath){
 		xmlDoc.addTag("points");
 		xmlDoc.pushTag("points");
 		
-		int numPoints = contourFinder.blobs[i].nPts;
+		int numPoints = shapes[i].nPts;
 		
 		for(int j=0; j<numPoints; j++){
 		
 			// save the points as attributes
 			xmlDoc.addTag("point");
-			xmlDoc.addAttribute("point", "x", contourFinder.blobs[i].pts[j].x, j);
-			xmlDoc.addAttribute("point", "y", contourFinder.blobs[i].pts[j].y, j);
+			xmlDoc.addAttribute("point", "x", shapes[i].pts[j].x, j);
+			xmlDoc.addAttribute("point", "y", shapes[i].pts[j].y, j);
 		}
 		
 		xmlDoc.popTag();
@@ -197,6 +189,14 @@ void testApp::keyPressed(int key){
 	if( key == 's' ){
 	
 		saveShapeDataAsXml("shapes.xml");
+	
+	} else if( key == '+' || key == '=' || key == '-' ){
+		
+		// change the threshold
+		// the search only looks at the pixels with colors near the picked one, so this is quick
+		matchThreshold = MAX(1, matchThreshold + ( key == '-' ? -1 : 1 ));
+		
+		if( bColorPicked ) colorSearch.search(pickedColor, matchThreshold);
 	}
 }
 
@@ -216,28 +216,14 @@ void testApp::mouseMoved(int x, int y){
 
 void testApp::mouseDragged(int x, int y, int button){
 
-	// get the color
-	pickedColor = getColorAtPos(source.getPixelsRef(), x, y);
-	
-	// search for similar colors within the image
-	searchForColorInPixels(pickedColor, source.getPixelsRef(), matchThreshold);
-	
-	// get the vector outlines from the matching areas
-	convertToVectors(colorMap);
+	pickColor(x, y);
 }
 
 //--------------------------------------------------------------
 
 void testApp::mousePressed(int x, int y, int button){
 
-	// get the color
-	pickedColor = getColorAtPos(source.getPixelsRef(), x, y);
-	
-	// search for similar colors within the image
-	searchForColorInPixels(pickedColor, source.getPixelsRef(), matchThreshold);
-	
-	// get the vector outlines from the matching areas
-	convertToVectors(colorMap);
+	pickColor(x, y);
 }
 
 //--------------------------------------------------------------
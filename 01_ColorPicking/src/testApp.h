@@ -12,6 +12,8 @@ September 2012
 #include "ofMain.h"
 #include "ofxXmlSettings.h"
 #include "ofxOpenCv.h"
+#include "FrameRegion.h"
+#include "ColorSearch.h"
 
 class testApp : public ofBaseApp{
 	
@@ -22,8 +24,7 @@ public:
 	void draw();
 	
 	ofColor getColorAtPos(ofPixels & pixels, int x, int y);
-	void searchForColorInPixels(ofColor & color, ofPixels & pixels, int thresh);
-	void convertToVectors(ofxCvGrayscaleImage & map);
+	void pickColor(int x, int y);
 	void saveShapeDataAsXml(string filePath);
 	
 	void keyPressed(int key);
@@ -35,8 +36,11 @@ public:
 	
 	ofImage source;
 	ofColor pickedColor;
+	bool bColorPicked;
 	int matchThreshold;
 	
+	FrameRegion region;
 	ofxCvGrayscaleImage colorMap;
-	ofxCvContourFinder 	contourFinder;
+	vector<ofxCvBlob> shapes;
+	ColorSearch colorSearch;
 };
@@ -0,0 +1,683 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxXmlSettings.h"
+#include "ShapeExtractor.h"
+#include "ShapeTracker.h"
+#include "FrameFingerprint.h"
+#include "ExtractionCache.h"
+#include "SegmentedExtraction.h"
+
+// tracks a whole list of movies & stills, each with its own color & threshold
+// the list is read from batch.xml in the data folder:
+//
+// <batch>
+//   <chunkSize>100</chunkSize>
+//   <item>
+//     <path>Explosion.mov</path>
+//     <red>225</red> <green>140</green> <blue>60</blue>
+//     <threshold>13</threshold>
+//     <blur>5</blur>
+//     <region> <findBars>1</findBars> </region>   (see FrameRegion)
+//   </item>
+//   <item>
+//     <path>Robocop01.png</path>
+//     ...
+//   </item>
+// </batch>
+//
+// each movie is cut into chunks of frames, & each chunk is a job for one thread
+// every thread starts with its own run of chunks (so it keeps decoding the same movie), then when
+// it runs out it steals chunks from the end of another thread's run
+// a finished chunk is saved straight away, so if the batch is stopped it starts again where it was
+// once all of a movie's chunks are done they're joined & saved into the extraction cache,
+// so the app loads the movie's shapes without tracking it
+
+struct BatchItem {
+
+	// give an extractor the item's settings
+
+	void copySettingsTo(ShapeExtractor & extractor){
+
+		extractor.searchColor = searchColor;
+		extractor.threshold = threshold;
+		extractor.blurSize = blurSize;
+		extractor.minShapeArea = minShapeArea;
+		extractor.maxShapeArea = maxShapeArea;
+		extractor.maxShapes = maxShapes;
+		extractor.region = region;
+	}
+
+	string path;
+	bool bImage;
+	int numFrames;
+
+	ofColor searchColor;
+	int threshold;
+	int blurSize;
+	int minShapeArea;
+	int maxShapeArea;
+	int maxShapes;
+	FrameRegion region;
+
+	ExtractionCache cache;
+	int numChunks;
+	int numChunksDone;
+	int numChunksFailed;
+};
+
+struct BatchJob {
+
+	int item;
+	int chunk;
+	int firstFrame;
+	int lastFrame;
+};
+
+class BatchRunner;
+
+//--------------------------------------------------------------
+
+class BatchWorker : public ofThread {
+
+public:
+
+	BatchWorker(){
+
+		runner = NULL;
+		loadedItem = -1;
+	}
+
+	~BatchWorker(){
+
+		stop();
+	}
+
+	void stop(){
+
+		if( isThreadRunning() ){
+
+			stopThread();
+			waitForThread(false);
+		}
+	}
+
+	void threadedFunction();
+	bool loadItem(BatchItem & item);
+	bool runJob(BatchJob & job, BatchItem & item);
+
+	BatchRunner * runner;
+	int index;
+
+	// this thread's run of jobs, it takes from the front & other threads steal from the back
+	deque<BatchJob> jobs;
+
+	int loadedItem;
+
+	// only touched on the worker's thread, it's opened in loadItem & closed when the thread is done
+	// (a QuickTime movie can only be used on the thread it was opened on)
+	ofVideoPlayer movie;
+	ofImage image;
+	ShapeExtractor extractor;
+	ShapeTracker tracker;
+	FrameFingerprint fingerprint;
+	FrameFingerprint lastFingerprint;
+};
+
+//--------------------------------------------------------------
+
+class BatchRunner {
+
+public:
+
+	//--------------------------------------------------------------
+
+	BatchRunner(){
+
+		chunkSize = 100;
+		renderSeed = 1;
+	}
+
+	~BatchRunner(){
+
+		stop();
+	}
+
+	//--------------------------------------------------------------
+
+	// read the list of movies, skip everything that's already done & start the threads
+	// settings missing from an item are taken from defaults
+
+	bool start(string filePath, ShapeExtractor & defaults, int seed){
+
+		stop();
+
+		ofxXmlSettings xmlDoc;
+
+		if( !xmlDoc.loadFile(filePath) || !xmlDoc.tagExists("batch") ){
+
+			ofLog(OF_LOG_ERROR, "Failed to load batch list " + filePath);
+			return false;
+		}
+
+		renderSeed = seed;
+		items.clear();
+
+		xmlDoc.pushTag("batch");
+
+		chunkSize = MAX(1, xmlDoc.getValue("chunkSize", 100));
+
+		for(int i=0; i<xmlDoc.getNumTags("item"); i++){
+
+			xmlDoc.pushTag("item", i);
+
+			BatchItem item;
+			item.path = xmlDoc.getValue("path", "");
+			item.searchColor.set(xmlDoc.getValue("red", defaults.searchColor.r), xmlDoc.getValue("green", defaults.searchColor.g), xmlDoc.getValue("blue", defaults.searchColor.b));
+			item.threshold = xmlDoc.getValue("threshold", defaults.threshold);
+			item.blurSize = xmlDoc.getValue("blur", defaults.blurSize);
+			item.minShapeArea = xmlDoc.getValue("minArea", defaults.minShapeArea);
+			item.maxShapeArea = xmlDoc.getValue("maxArea", defaults.maxShapeArea);
+			item.maxShapes = xmlDoc.getValue("maxShapes", defaults.maxShapes);
+			item.region = defaults.region;
+			item.region.loadSettings(xmlDoc);
+
+			xmlDoc.popTag();
+
+			if( findNumFrames(item) ) items.push_back(item);
+		}
+
+		xmlDoc.popTag();
+
+		// one worker for each core
+		int numWorkers = getNumCores();
+
+		for(int i=0; i<numWorkers; i++){
+
+			BatchWorker * worker = new BatchWorker();
+			worker->runner = this;
+			worker->index = i;
+			workers.push_back(worker);
+		}
+
+		// cut the items into chunks, skipping the ones that were finished last time
+		vector<BatchJob> jobs;
+
+		for(int i=0; i<items.size(); i++){
+
+			BatchItem & item = items[i];
+
+			item.numChunks = (item.numFrames + chunkSize - 1) / chunkSize;
+			item.numChunksDone = 0;
+			item.numChunksFailed = 0;
+
+			if( ofFile::doesFileExist(item.cache.getPath()) ){
+
+				ofLogNotice("Already tracked " + item.path);
+				item.numChunksDone = item.numChunks;
+				continue;
+			}
+
+			for(int c=0; c<item.numChunks; c++){
+
+				BatchJob job;
+				job.item = i;
+				job.chunk = c;
+				job.firstFrame = c * chunkSize;
+				job.lastFrame = MIN(item.numFrames, (c + 1) * chunkSize);
+
+				ShapeSequenceReader checkpoint;
+
+				if( checkpoint.open(getChunkPath(job)) && checkpoint.getNumFrames() == job.lastFrame - job.firstFrame ){
+
+					item.numChunksDone++;
+
+				} else {
+
+					jobs.push_back(job);
+				}
+			}
+
+			// everything was done but joining the chunks
+			if( item.numChunksDone == item.numChunks ) joinChunks(i);
+		}
+
+		// give each worker a run of jobs one after another
+		for(int j=0; j<jobs.size(); j++){
+
+			workers[j * numWorkers / jobs.size()]->jobs.push_back(jobs[j]);
+		}
+
+		ofLogNotice("Batch of " + ofToString(items.size()) + " items, " + ofToString((int)jobs.size()) + " chunks to track");
+
+		for(int i=0; i<workers.size(); i++){
+
+			workers[i]->startThread(false, false);
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// open each item (on the main thread) to find out how many frames it has
+
+	bool findNumFrames(BatchItem & item){
+
+		string extension = ofToLower(ofFilePath::getFileExt(item.path));
+		item.bImage = ( extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tif" || extension == "tiff" || extension == "bmp" );
+
+		if( item.bImage ){
+
+			item.numFrames = 1;
+
+		} else {
+
+			ofVideoPlayer movie;
+
+			if( !movie.loadMovie(item.path) ){
+
+				ofLog(OF_LOG_ERROR, "Failed to load " + item.path + ", skipping it");
+				return false;
+			}
+
+			item.numFrames = movie.getTotalNumFrames();
+			movie.close();
+		}
+
+		// the same key the app uses, so the app finds the shapes in its cache
+		ShapeExtractor settings;
+		item.copySettingsTo(settings);
+
+		item.cache.reset();
+		item.cache.addFile(item.path);
+		settings.addToKey(item.cache, item.threshold, item.blurSize, renderSeed);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// the next job for a worker, its own if it has any left, otherwise one stolen from another worker
+	// (a job is a whole chunk of frames, so one lock for all of the queues is plenty)
+
+	bool getJob(int workerIndex, BatchJob & job){
+
+		ofScopedLock lock(mutex);
+
+		deque<BatchJob> & own = workers[workerIndex]->jobs;
+
+		if( own.size() > 0 ){
+
+			job = own.front();
+			own.pop_front();
+			return true;
+		}
+
+		// steal from the worker with the most left
+		int victim = -1;
+
+		for(int i=0; i<workers.size(); i++){
+
+			if( workers[i]->jobs.size() > 0 && (victim < 0 || workers[i]->jobs.size() > workers[victim]->jobs.size()) ) victim = i;
+		}
+
+		if( victim < 0 ) return false;
+
+		job = workers[victim]->jobs.back();
+		workers[victim]->jobs.pop_back();
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// a chunk has been saved, join the item's chunks if it was the last one
+
+	void finishJob(BatchJob & job){
+
+		bool bItemDone;
+
+		{
+			ofScopedLock lock(mutex);
+
+			BatchItem & item = items[job.item];
+			item.numChunksDone++;
+			bItemDone = ( item.numChunksDone == item.numChunks );
+		}
+
+		if( bItemDone ) joinChunks(job.item);
+	}
+
+	//--------------------------------------------------------------
+
+	// a chunk couldn't be tracked, the item isn't joined (the rest of its chunks are kept for next time)
+
+	void failJob(BatchJob & job){
+
+		ofScopedLock lock(mutex);
+
+		BatchItem & item = items[job.item];
+		item.numChunksFailed++;
+
+		ofLog(OF_LOG_ERROR, "Failed to track frames " + ofToString(job.firstFrame) + " to " + ofToString(job.lastFrame) + " of " + item.path);
+	}
+
+	//--------------------------------------------------------------
+
+	// join an item's chunks into the cache a frame at a time, linking the shapes across the chunks,
+	// then delete the chunks (only one chunk is open at once, so a long movie never has to fit in memory)
+
+	void joinChunks(int itemIndex){
+
+		BatchItem & item = items[itemIndex];
+
+		ShapeSequenceWriter writer;
+
+		if( !item.cache.beginSave(writer) ){
+
+			ofLog(OF_LOG_ERROR, "Failed to create " + item.cache.getPath() + ".tmp");
+			return;
+		}
+
+		ShapeStitcher stitcher;
+		ShapeCollection frame;
+
+		for(int c=0; c<item.numChunks; c++){
+
+			BatchJob job;
+			job.item = itemIndex;
+			job.chunk = c;
+			job.firstFrame = c * chunkSize;
+
+			ShapeSequenceReader reader;
+
+			if( !reader.open(getChunkPath(job)) ){
+
+				ofLog(OF_LOG_ERROR, "Missing chunk " + getChunkPath(job));
+				writer.close();
+				ofFile::removeFile(item.cache.getPath() + ".tmp");
+				return;
+			}
+
+			for(int i=0; i<reader.getNumFrames(); i++){
+
+				reader.getFrame(i, frame);
+				stitcher.addFrame(frame);
+				writer.addFrame(frame);
+			}
+
+			if( reader.getNumFrames() > 0 ) stitcher.endPart(frame);
+		}
+
+		if( !item.cache.endSave(writer) ){
+
+			ofLog(OF_LOG_ERROR, "Failed to save shapes to " + item.cache.getPath());
+			return;
+		}
+
+		for(int c=0; c<item.numChunks; c++){
+
+			BatchJob job;
+			job.item = itemIndex;
+			job.chunk = c;
+			job.firstFrame = c * chunkSize;
+
+			ofFile::removeFile(getChunkPath(job));
+		}
+
+		ofLogNotice("Finished " + item.path + ", saved to " + item.cache.getPath());
+	}
+
+	//--------------------------------------------------------------
+
+	string getChunkPath(BatchJob & job){
+
+		BatchItem & item = items[job.item];
+
+		return item.cache.folder + "/" + item.cache.getKey() + "_" + ofToString(job.firstFrame) + ".part";
+	}
+
+	//--------------------------------------------------------------
+
+	bool isRunning(){
+
+		return workers.size() > 0;
+	}
+
+	// every chunk has either been saved or has failed
+
+	bool isFinished(){
+
+		return getNumChunksDone() + getNumChunksFailed() == getNumChunks();
+	}
+
+	int getNumChunks(){
+
+		int numChunks = 0;
+
+		for(int i=0; i<items.size(); i++){
+
+			numChunks += items[i].numChunks;
+		}
+
+		return numChunks;
+	}
+
+	int getNumChunksDone(){
+
+		ofScopedLock lock(mutex);
+
+		int numDone = 0;
+
+		for(int i=0; i<items.size(); i++){
+
+			numDone += items[i].numChunksDone;
+		}
+
+		return numDone;
+	}
+
+	int getNumChunksFailed(){
+
+		ofScopedLock lock(mutex);
+
+		int numFailed = 0;
+
+		for(int i=0; i<items.size(); i++){
+
+			numFailed += items[i].numChunksFailed;
+		}
+
+		return numFailed;
+	}
+
+	//--------------------------------------------------------------
+
+	void logFailedItems(){
+
+		ofScopedLock lock(mutex);
+
+		for(int i=0; i<items.size(); i++){
+
+			if( items[i].numChunksFailed > 0 ){
+
+				ofLog(OF_LOG_ERROR, "Failed to track " + ofToString(items[i].numChunksFailed) + " of " + ofToString(items[i].numChunks) + " chunks of " + items[i].path);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// stop the threads, the chunks that are finished are kept for next time
+
+	void stop(){
+
+		for(int i=0; i<workers.size(); i++){
+
+			delete workers[i];
+		}
+
+		workers.clear();
+	}
+
+	int chunkSize;
+	int renderSeed;
+
+	vector<BatchItem> items;
+	vector<BatchWorker*> workers;
+	ofMutex mutex;
+};
+
+//--------------------------------------------------------------
+
+inline void BatchWorker::threadedFunction(){
+
+	BatchJob job;
+
+	while( isThreadRunning() && runner->getJob(index, job) ){
+
+		// items don't change once the batch has started, so they can be read without locking
+		BatchItem & item = runner->items[job.item];
+
+		// (a job that was stopped part way through hasn't failed, it's done next time)
+		if( runJob(job, item) ){
+
+			runner->finishJob(job);
+
+		} else if( isThreadRunning() ){
+
+			runner->failJob(job);
+		}
+	}
+
+	movie.close();
+	loadedItem = -1;
+}
+
+//--------------------------------------------------------------
+
+// open a movie or still (without a texture) & get the extractor ready for it
+
+inline bool BatchWorker::loadItem(BatchItem & item){
+
+	if( item.bImage ){
+
+		image.setUseTexture(false);
+
+		if( !image.loadImage(item.path) ) return false;
+
+		image.setImageType(OF_IMAGE_COLOR);
+
+	} else {
+
+		movie.setUseTexture(false);
+
+		if( !movie.loadMovie(item.path) ) return false;
+	}
+
+	int width = item.bImage ? image.getWidth() : movie.getWidth();
+	int height = item.bImage ? image.getHeight() : movie.getHeight();
+
+	item.copySettingsTo(extractor);
+
+	// every worker finds the same bars, so the chunks all match
+	if( item.region.bFindBars ){
+
+		if( item.bImage ){
+
+			extractor.region.clearBarSamples();
+			extractor.region.addBarSample(image.getPixelsRef());
+			extractor.region.findBarsFromSamples();
+
+		} else {
+
+			extractor.region.findBars(movie);
+		}
+	}
+
+	extractor.setup(width, height, false);
+
+	return true;
+}
+
+//--------------------------------------------------------------
+
+// track a chunk of frames & save them as a checkpoint
+// every chunk starts tracking from scratch, so a chunk comes out the same whichever thread does it
+
+inline bool BatchWorker::runJob(BatchJob & job, BatchItem & item){
+
+	if( loadedItem != job.item ){
+
+		loadedItem = -1;
+
+		if( !loadItem(item) ){
+
+			ofLog(OF_LOG_ERROR, "Failed to load " + item.path);
+			return false;
+		}
+
+		loadedItem = job.item;
+	}
+
+	string path = runner->getChunkPath(job);
+
+	ShapeSequenceWriter writer;
+
+	if( !writer.open(path + ".tmp") ) return false;
+
+	tracker.reset();
+	lastFingerprint.clear();
+
+	ShapeCollection lastShapes;
+
+	// start from the frame before the chunk, so a chunk that starts on a repeat
+	// gets that frame's shapes again instead of finding them from scratch
+	// (the ids still start again, they're only joined up afterwards, see ShapeStitcher)
+	if( !item.bImage && job.firstFrame > 0 ){
+
+		movie.setFrame(job.firstFrame - 1);
+		movie.update();
+
+		lastFingerprint.set(movie.getPixelsRef());
+		extractor.extract(movie.getPixelsRef(), lastShapes, runner->renderSeed + job.firstFrame - 1);
+		tracker.track(lastShapes);
+	}
+
+	for(int frame=job.firstFrame; frame<job.lastFrame; frame++){
+
+		if( !isThreadRunning() ) return false;
+
+		if( !item.bImage ){
+
+			movie.setFrame(frame);
+			movie.update();
+		}
+
+		ofPixels & pixels = item.bImage ? image.getPixelsRef() : movie.getPixelsRef();
+
+		// a frame that's the same as the last one we found shapes in gets the same shapes
+		fingerprint.set(pixels);
+
+		bool bRepeated = fingerprint.matches(lastFingerprint);
+
+		if( !bRepeated ){
+
+			lastFingerprint.swap(fingerprint);
+
+			lastShapes = ShapeCollection();
+			extractor.extract(pixels, lastShapes, runner->renderSeed + frame);
+			tracker.track(lastShapes);
+		}
+
+		// (a repeat at the start of the chunk has its shapes saved, there's no frame before it in the file)
+		lastShapes.bRepeated = bRepeated;
+		writer.addFrame(lastShapes);
+	}
+
+	writer.close();
+
+	return rename(ofToDataPath(path + ".tmp").c_str(), ofToDataPath(path).c_str()) == 0;
+}
@@ -0,0 +1,221 @@
+
+#pragma once
+
+#include "ofMain.h"
+
+// keeps compressed snapshots ("keyframes") of the splatter canvas
+// the canvas builds up over time, so to show frame N we would have to replay every frame before it
+// instead we restore the closest keyframe and only replay the frames since then
+// (a keyframe is only there once something has drawn up to it, see testApp::buildKeyframes)
+
+class CanvasKeyframes {
+
+public:
+
+	//--------------------------------------------------------------
+
+	CanvasKeyframes(){
+
+		interval = 10;
+		totalFrames = 0;
+		memoryBudget = 64 * 1024 * 1024;
+		memoryUsed = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	// set how many frames we'll be playing and how much memory we can use for snapshots
+	// the interval between keyframes grows until all of the keyframes fit in the budget
+
+	void setup(int numFrames, int budgetInBytes, int minInterval = 10){
+
+		clear();
+
+		totalFrames = numFrames;
+		memoryBudget = budgetInBytes;
+		interval = MAX(1, minInterval);
+	}
+
+	//--------------------------------------------------------------
+
+	void clear(){
+
+		snapshots.clear();
+		memoryUsed = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	int getInterval(){
+
+		return interval;
+	}
+
+	int getMemoryUsed(){
+
+		return memoryUsed;
+	}
+
+	int getNumKeyframes(){
+
+		return snapshots.size();
+	}
+
+	//--------------------------------------------------------------
+
+	// should a snapshot be taken at this frame?
+
+	bool isKeyframe(int frame){
+
+		return frame % interval == 0 && snapshots.find(frame) == snapshots.end();
+	}
+
+	//--------------------------------------------------------------
+
+	// compress the canvas and store it
+
+	void addKeyframe(int frame, ofFbo & canvas){
+
+		ofPixels pixels;
+		canvas.readToPixels(pixels);
+
+		vector<unsigned char> & data = snapshots[frame];
+		compress(pixels, data);
+		memoryUsed += data.size();
+
+		// estimate how much memory a keyframe at every interval would need for the whole movie
+		// if that's over budget, double the interval and drop the keyframes that are in between
+		int averageSize = memoryUsed / snapshots.size();
+
+		while( (float)totalFrames / interval * averageSize > memoryBudget && interval < totalFrames ){
+
+			interval *= 2;
+
+			map<int, vector<unsigned char> >::iterator it = snapshots.begin();
+
+			while( it != snapshots.end() ){
+
+				if( it->first % interval != 0 ){
+
+					memoryUsed -= it->second.size();
+					snapshots.erase(it++);
+
+				} else {
+
+					++it;
+				}
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// find the closest keyframe at or before this frame
+	// returns -1 if there isn't one (start from a blank canvas)
+
+	int getKeyframeBefore(int frame){
+
+		map<int, vector<unsigned char> >::iterator it = snapshots.upper_bound(frame);
+
+		if( it == snapshots.begin() ) return -1;
+
+		--it;
+		return it->first;
+	}
+
+	//--------------------------------------------------------------
+
+	// draw a stored snapshot back into the canvas
+
+	void restoreKeyframe(int frame, ofFbo & canvas){
+
+		if( snapshots.find(frame) == snapshots.end() ) return;
+
+		ofPixels pixels;
+		decompress(snapshots[frame], pixels);
+
+		snapshotImage.setFromPixels(pixels);
+
+		canvas.begin();
+		ofSetColor(255, 255, 255);
+		snapshotImage.draw(0, 0);
+		canvas.end();
+	}
+
+	//--------------------------------------------------------------
+
+	// run-length encode the pixels
+	// the canvas is mostly flat paper & flat paint colors, so this shrinks it a lot
+	// each run is stored as a count (1-255) followed by one pixel
+
+	void compress(ofPixels & pixels, vector<unsigned char> & data){
+
+		int width = pixels.getWidth();
+		int height = pixels.getHeight();
+		int channels = pixels.getNumChannels();
+		int numPix = width * height;
+		unsigned char * pix = pixels.getPixels();
+
+		data.clear();
+
+		// a small header with the image size
+		data.push_back(width & 0xff);
+		data.push_back((width >> 8) & 0xff);
+		data.push_back(height & 0xff);
+		data.push_back((height >> 8) & 0xff);
+		data.push_back(channels);
+
+		int i = 0;
+
+		while( i < numPix ){
+
+			unsigned char * runPix = pix + i * channels;
+			int runLength = 1;
+
+			while( i + runLength < numPix && runLength < 255 && memcmp(runPix, pix + (i + runLength) * channels, channels) == 0 ){
+
+				runLength++;
+			}
+
+			data.push_back(runLength);
+			data.insert(data.end(), runPix, runPix + channels);
+
+			i += runLength;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void decompress(vector<unsigned char> & data, ofPixels & pixels){
+
+		int width = data[0] | (data[1] << 8);
+		int height = data[2] | (data[3] << 8);
+		int channels = data[4];
+
+		pixels.allocate(width, height, channels);
+		unsigned char * pix = pixels.getPixels();
+
+		int pos = 5;
+
+		while( pos < data.size() ){
+
+			int runLength = data[pos];
+
+			for(int i=0; i<runLength; i++){
+
+				memcpy(pix, &data[pos+1], channels);
+				pix += channels;
+			}
+
+			pos += 1 + channels;
+		}
+	}
+
+	int interval;
+	int totalFrames;
+	int memoryBudget;
+	int memoryUsed;
+
+	map<int, vector<unsigned char> > snapshots;
+	ofImage snapshotImage;
+};
@@ -0,0 +1,170 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeCollection.h"
+#include "ShapeSequenceFile.h"
+#include "FrameStore.h"
+
+// keeps the shapes extracted from a movie so the next run can skip tracking
+// each entry is named after a hash of the movie file and every setting that changes the shapes
+// so a different movie or different settings never pick up stale shapes
+
+// bump this when the way shapes are extracted changes, so old entries are ignored
+#define EXTRACTION_CACHE_VERSION 2
+
+class ExtractionCache {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ExtractionCache(){
+
+		folder = "cache";
+		reset();
+	}
+
+	//--------------------------------------------------------------
+
+	// start a new key
+
+	void reset(){
+
+		hash = 14695981039346656037ULL;
+		addValue(SHAPE_SEQUENCE_VERSION);
+		addValue(EXTRACTION_CACHE_VERSION);
+	}
+
+	//--------------------------------------------------------------
+
+	// add bytes to the key (FNV-1a hash)
+
+	void addBytes(const unsigned char * bytes, int numBytes){
+
+		for(int i=0; i<numBytes; i++){
+
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	void addValue(int value){
+
+		addBytes((unsigned char*)&value, sizeof(value));
+	}
+
+	void addValue(float value){
+
+		addBytes((unsigned char*)&value, sizeof(value));
+	}
+
+	//--------------------------------------------------------------
+
+	// add the whole contents of a file to the key
+
+	bool addFile(string filePath){
+
+		FILE * file = fopen(ofToDataPath(filePath).c_str(), "rb");
+
+		if( file == NULL ) return false;
+
+		vector<unsigned char> chunk(1024 * 1024);
+		size_t numRead;
+
+		while( (numRead = fread(&chunk[0], 1, chunk.size(), file)) > 0 ){
+
+			addBytes(&chunk[0], numRead);
+		}
+
+		fclose(file);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	string getKey(){
+
+		char key[17];
+		sprintf(key, "%016llx", (unsigned long long)hash);
+
+		return key;
+	}
+
+	string getPath(){
+
+		return folder + "/" + getKey() + ".shapes";
+	}
+
+	//--------------------------------------------------------------
+
+	// use the frames in the cache, returns false if there's no entry for this key
+	// (they're only read from the entry when they're used)
+
+	bool load(FrameStore & frames){
+
+		return frames.open(getPath());
+	}
+
+	//--------------------------------------------------------------
+
+	// save all of the frames into the cache
+
+	bool save(vector<ShapeCollection> & frames){
+
+		ShapeSequenceWriter writer;
+
+		if( !beginSave(writer) ) return false;
+
+		for(int i=0; i<frames.size(); i++){
+
+			writer.addFrame(frames[i]);
+		}
+
+		return endSave(writer);
+	}
+
+	//--------------------------------------------------------------
+
+	// or save the frames one at a time as they're extracted
+	// they're written to a temporary file first, so an interrupted save never looks like a valid entry
+
+	bool beginSave(ShapeSequenceWriter & writer){
+
+		ofDirectory::createDirectory(folder);
+
+		return writer.open(getPath() + ".tmp");
+	}
+
+	bool endSave(ShapeSequenceWriter & writer){
+
+		writer.close();
+
+		return rename(ofToDataPath(getPath() + ".tmp").c_str(), ofToDataPath(getPath()).c_str()) == 0;
+	}
+
+	//--------------------------------------------------------------
+
+	// or keep the frames in a store that writes them into the entry as they're added
+
+	bool beginSave(FrameStore & frames){
+
+		ofDirectory::createDirectory(folder);
+
+		return frames.beginWriting(getPath() + ".tmp");
+	}
+
+	bool endSave(FrameStore & frames){
+
+		if( !endSave(frames.writer) ) return false;
+
+		// the frames can be streamed from the finished entry now
+		frames.finishedWriting(getPath());
+
+		return true;
+	}
+
+	string folder;
+	uint64_t hash;
+};
@@ -0,0 +1,179 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxXmlSettings.h"
+#include "ExtractionCache.h"
+#include "ShapeTracker.h"
+
+// a list of thresholds & blur sizes to try on the same movie
+// each frame is decoded once and every setting is extracted from it,
+// so trying 10 thresholds costs much less than tracking the movie 10 times
+// the shapes for each setting are saved into the extraction cache,
+// so picking one of them afterwards (& restarting) goes straight to playback
+//
+// the settings are read from sweep.xml in the data folder:
+//
+// <sweep>
+//   <threshold>10</threshold>
+//   <threshold>15</threshold>
+//   <blur>5</blur>
+// </sweep>
+//
+// every threshold is tried with every blur size
+
+class ExtractionSweep {
+
+public:
+
+	struct Setting {
+
+		int threshold;
+		int blurSize;
+		ExtractionCache cache;
+		ShapeTracker tracker;
+	};
+
+	//--------------------------------------------------------------
+
+	~ExtractionSweep(){
+
+		clearWriters();
+	}
+
+	//--------------------------------------------------------------
+
+	// read the settings to try
+	// without a settings file, try 10 thresholds from half to almost 1.5x the default
+
+	void setup(string filePath, int defaultThreshold, int defaultBlurSize){
+
+		vector<int> thresholds;
+		vector<int> blurSizes;
+
+		ofxXmlSettings xmlDoc;
+
+		if( xmlDoc.loadFile(filePath) && xmlDoc.tagExists("sweep") ){
+
+			xmlDoc.pushTag("sweep");
+
+			for(int i=0; i<xmlDoc.getNumTags("threshold"); i++){
+
+				thresholds.push_back(xmlDoc.getValue("threshold", defaultThreshold, i));
+			}
+
+			for(int i=0; i<xmlDoc.getNumTags("blur"); i++){
+
+				blurSizes.push_back(xmlDoc.getValue("blur", defaultBlurSize, i));
+			}
+
+			xmlDoc.popTag();
+		}
+
+		if( thresholds.size() == 0 ){
+
+			for(int i=0; i<10; i++){
+
+				thresholds.push_back(MAX(1, defaultThreshold * (0.5 + i * 0.1)));
+			}
+		}
+
+		if( blurSizes.size() == 0 ) blurSizes.push_back(defaultBlurSize);
+
+		settings.clear();
+
+		for(int i=0; i<thresholds.size(); i++){
+
+			for(int j=0; j<blurSizes.size(); j++){
+
+				Setting setting;
+				setting.threshold = thresholds[i];
+				setting.blurSize = blurSizes[j];
+				settings.push_back(setting);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// open a shape file for each setting
+	// (each setting's cache key has to be filled in first)
+
+	bool begin(){
+
+		clearWriters();
+
+		for(int i=0; i<settings.size(); i++){
+
+			settings[i].tracker.reset();
+
+			ShapeSequenceWriter * writer = new ShapeSequenceWriter();
+			writers.push_back(writer);
+
+			if( !settings[i].cache.beginSave(*writer) ){
+
+				clearWriters();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// add the next frame of shapes for a setting
+	// each setting tracks its own shapes from frame to frame
+
+	void addFrame(int settingIndex, ShapeCollection & frame){
+
+		settings[settingIndex].tracker.track(frame);
+		writers[settingIndex]->addFrame(frame);
+	}
+
+	//--------------------------------------------------------------
+
+	// add a frame that's the same as the last one for a setting
+	// (the tracker still has the last frame's shapes, so there's nothing to track)
+
+	void addRepeatedFrame(int settingIndex){
+
+		writers[settingIndex]->addRepeatedFrame();
+	}
+
+	//--------------------------------------------------------------
+
+	// finish every shape file & move it into the cache
+
+	void end(){
+
+		for(int i=0; i<writers.size(); i++){
+
+			if( settings[i].cache.endSave(*writers[i]) ){
+
+				ofLogNotice("Saved threshold " + ofToString(settings[i].threshold) + ", blur " + ofToString(settings[i].blurSize) + " to " + settings[i].cache.getPath());
+
+			} else {
+
+				ofLog(OF_LOG_WARNING, "Failed to save threshold " + ofToString(settings[i].threshold) + ", blur " + ofToString(settings[i].blurSize) + " to " + settings[i].cache.getPath());
+			}
+		}
+
+		clearWriters();
+	}
+
+	//--------------------------------------------------------------
+
+	void clearWriters(){
+
+		for(int i=0; i<writers.size(); i++){
+
+			delete writers[i];
+		}
+
+		writers.clear();
+	}
+
+	vector<Setting> settings;
+	vector<ShapeSequenceWriter*> writers;
+};
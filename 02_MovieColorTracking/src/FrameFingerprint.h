@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ofMain.h"
+
+// a tiny summary of a frame, to spot frames that are the same as the one before
+// (held titles, freeze frames, the doubled frames in telecined video)
+// every 4th pixel of every 4th row is kept as it is (each color channel), & two frames only match
+// if every one of those pixels is nearly the same, so anything bigger than a few pixels that moves
+// or changes color stops them matching (averaging parts of the frame would hide a small object moving)
+
+class FrameFingerprint {
+
+public:
+
+	//--------------------------------------------------------------
+
+	FrameFingerprint(){
+
+		width = height = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	void set(ofPixels & pixels){
+
+		width = pixels.getWidth();
+		height = pixels.getHeight();
+		int channels = pixels.getNumChannels();
+		unsigned char * pix = pixels.getPixels();
+
+		// alpha doesn't count
+		int numColors = ( channels >= 3 ) ? 3 : 1;
+
+		samples.clear();
+		samples.reserve(((width + stride - 1) / stride) * ((height + stride - 1) / stride) * numColors);
+
+		for(int y=0; y<height; y+=stride){
+
+			unsigned char * p = pix + y * width * channels;
+
+			for(int x=0; x<width; x+=stride){
+
+				samples.insert(samples.end(), p, p + numColors);
+				p += stride * channels;
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void clear(){
+
+		samples.clear();
+	}
+
+	// (cheaper than copying)
+	void swap(FrameFingerprint & other){
+
+		samples.swap(other.samples);
+		std::swap(width, other.width);
+		std::swap(height, other.height);
+	}
+
+	//--------------------------------------------------------------
+
+	// are the frames the same, give or take a little compression noise in each pixel?
+
+	bool matches(FrameFingerprint & other, int tolerance = 8){
+
+		if( samples.size() == 0 || samples.size() != other.samples.size() || width != other.width || height != other.height ) return false;
+
+		for(int i=0; i<samples.size(); i++){
+
+			if( abs(samples[i] - other.samples[i]) > tolerance ) return false;
+		}
+
+		return true;
+	}
+
+	static const int stride = 4;
+
+	int width;
+	int height;
+	vector<unsigned char> samples;
+};
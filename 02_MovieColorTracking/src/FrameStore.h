@@ -0,0 +1,397 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeCollection.h"
+#include "ShapeSequenceFile.h"
+#include "Poco/Event.h"
+
+// reads the frames after the one that was used last on its own thread, so they're ready in time
+// it has its own reader, so it never gets in the way of the store's reader
+// it stays at most lookahead frames ahead, & jumps when it's asked for a frame it doesn't have
+
+class FramePrefetcher : public ofThread {
+
+public:
+
+	//--------------------------------------------------------------
+
+	FramePrefetcher(){
+
+		lookahead = 8;
+		first = 0;
+		generation = 0;
+	}
+
+	~FramePrefetcher(){
+
+		stop();
+	}
+
+	//--------------------------------------------------------------
+
+	// start reading a finished shape sequence from the beginning
+
+	bool start(string filePath, int numAhead){
+
+		stop();
+
+		if( !reader.open(filePath) ) return false;
+
+		lookahead = MAX(1, numAhead);
+		first = 0;
+
+		startThread(false, false);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	void stop(){
+
+		if( isThreadRunning() ){
+
+			stopThread();
+			frameTaken.set();
+			waitForThread(false);
+		}
+
+		reader.close();
+		clearReady();
+	}
+
+	//--------------------------------------------------------------
+
+	// take a frame if it's been read (the caller owns it), then keep reading after it
+	// returns NULL if it hasn't been read, & starts reading after it instead
+
+	ShapeCollection * takeFrame(int index){
+
+		ofScopedLock lock(mutex);
+
+		// we've moved past these
+		while( ready.size() > 0 && first < index ){
+
+			delete ready.front();
+			ready.pop_front();
+			first++;
+		}
+
+		if( ready.size() > 0 && first == index ){
+
+			ShapeCollection * frame = ready.front();
+			ready.pop_front();
+			first++;
+
+			frameTaken.set();
+
+			return frame;
+		}
+
+		// a jump, anything being read now is for the wrong place
+		clearReady();
+		first = index + 1;
+		generation++;
+
+		frameTaken.set();
+
+		return NULL;
+	}
+
+	//--------------------------------------------------------------
+
+	void threadedFunction(){
+
+		while( isThreadRunning() ){
+
+			int index;
+			int readingGeneration;
+			bool bFarEnough;
+
+			{
+				ofScopedLock lock(mutex);
+
+				index = first + ready.size();
+				readingGeneration = generation;
+				bFarEnough = ready.size() >= lookahead;
+			}
+
+			if( bFarEnough || index >= reader.getNumFrames() ){
+
+				// far enough ahead, wait for a frame to be taken
+				// (waking up now and then to see if we've been stopped)
+				frameTaken.tryWait(100);
+				continue;
+			}
+
+			// read without the lock, so taking frames never waits for reading
+			ShapeCollection * frame = new ShapeCollection();
+			reader.getFrame(index, *frame);
+
+			ofScopedLock lock(mutex);
+
+			if( readingGeneration == generation && index == first + ready.size() ) ready.push_back(frame);
+			else delete frame;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void clearReady(){
+
+		for(int i=0; i<ready.size(); i++){
+
+			delete ready[i];
+		}
+
+		ready.clear();
+	}
+
+	ShapeSequenceReader reader; // only used on the thread
+	int lookahead;
+
+	// the frames that have been read, from first on (lock before touching them)
+	deque<ShapeCollection*> ready;
+	int first;
+	int generation; // goes up with every jump
+	Poco::Event frameTaken; // or there's been a jump
+};
+
+//--------------------------------------------------------------
+
+// holds the shapes of every frame of a movie, without needing all of them in memory
+// frames are written to the end of a shape sequence file as they're added, so once the frames
+// in memory go over the budget the oldest ones can be let go of & read back from the file when
+// they're used again (playing, saving & rendering go through the frames in order, so reading
+// them back is cheap, see ShapeSequenceReader)
+// the file is the extraction cache's entry, so the shapes are saved as they're tracked
+// & the frames of a movie that's already been tracked are only read from its entry when they're used
+// once the file is finished, the frames after the one being used are read ahead on another thread,
+// so playing streams from the file with only a few frames in memory
+
+class FrameStore {
+
+public:
+
+	//--------------------------------------------------------------
+
+	FrameStore(){
+
+		memoryBudget = 0;
+		memoryUsed = 0;
+		fd = -1;
+		lookahead = 8;
+	}
+
+	~FrameStore(){
+
+		clear();
+	}
+
+	//--------------------------------------------------------------
+
+	// how much memory the frames in memory can use (0 keeps every frame in memory)
+
+	void setMemoryBudget(uint64_t budgetInBytes){
+
+		memoryBudget = budgetInBytes;
+		evict();
+	}
+
+	//--------------------------------------------------------------
+
+	// how many frames to read ahead of the one being used, once the file is finished (0 doesn't)
+
+	void setLookahead(int numFrames){
+
+		lookahead = numFrames;
+		startPrefetching();
+	}
+
+	//--------------------------------------------------------------
+
+	// start a new set of frames, writing them to a file as they're added
+
+	bool beginWriting(string filePath){
+
+		clear();
+
+		if( !writer.open(filePath) ) return false;
+
+		// the file is read back through its own descriptor, so it can be renamed when it's finished
+		fd = ::open(ofToDataPath(filePath).c_str(), O_RDONLY);
+
+		return fd >= 0;
+	}
+
+	//--------------------------------------------------------------
+
+	// use the frames in a finished file, they're read from the file when they're used
+
+	bool open(string filePath){
+
+		clear();
+
+		if( !reader.open(filePath) ) return false;
+
+		frames.assign(reader.getNumFrames(), (ShapeCollection*)NULL);
+		finishedWriting(filePath);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// the file's finished (& maybe renamed), so it can be read ahead
+
+	void finishedWriting(string filePath){
+
+		finishedPath = filePath;
+		startPrefetching();
+	}
+
+	void startPrefetching(){
+
+		if( lookahead > 0 && finishedPath != "" ) prefetcher.start(finishedPath, lookahead);
+		else prefetcher.stop();
+	}
+
+	//--------------------------------------------------------------
+
+	void clear(){
+
+		prefetcher.stop();
+		finishedPath = "";
+
+		for(int i=0; i<frames.size(); i++){
+
+			delete frames[i];
+		}
+
+		frames.clear();
+		inMemory.clear();
+		memoryUsed = 0;
+
+		writer.close();
+		reader.close();
+
+		if( fd >= 0 ){
+
+			::close(fd);
+			fd = -1;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	int size(){
+
+		return frames.size();
+	}
+
+	//--------------------------------------------------------------
+
+	// add a frame to the end (write it to the file, if there is one)
+
+	void push_back(ShapeCollection & frame){
+
+		if( writer.isOpen() ) writer.addFrame(frame);
+
+		frames.push_back( new ShapeCollection(frame) );
+		keep(frames.size() - 1);
+	}
+
+	//--------------------------------------------------------------
+
+	// get a frame, reading it from the file if it isn't in memory
+	// getting another frame can let go of this one, so don't hold on to it
+
+	ShapeCollection & operator[](int i){
+
+		if( frames[i] == NULL ){
+
+			if( prefetcher.isThreadRunning() ) frames[i] = prefetcher.takeFrame(i);
+
+			// it hasn't been read ahead, read it now
+			if( frames[i] == NULL ){
+
+				// if frames have been written since the file was mapped, map it again
+				// (the writer's index may have moved too)
+				if( fd >= 0 && reader.getNumFrames() != writer.getNumFrames() ){
+
+					writer.flush();
+					reader.openUnfinished(fd, writer.index, writer.keyframeInterval);
+				}
+
+				frames[i] = new ShapeCollection();
+				reader.getFrame(i, *frames[i]);
+			}
+
+			keep(i);
+		}
+
+		return *frames[i];
+	}
+
+	ShapeCollection & back(){
+
+		return (*this)[frames.size() - 1];
+	}
+
+	//--------------------------------------------------------------
+
+	int getNumInMemory(){
+
+		return inMemory.size();
+	}
+
+	uint64_t getMemoryUsed(){
+
+		return memoryUsed;
+	}
+
+	//--------------------------------------------------------------
+
+	// count a frame that's now in memory, then let go of the oldest frames if we're over the budget
+
+	void keep(int i){
+
+		inMemory.push_back(i);
+		memoryUsed += frames[i]->getMemorySize();
+
+		evict();
+	}
+
+	void evict(){
+
+		// frames can only be let go of if they can be read back
+		if( memoryBudget == 0 || (fd < 0 && !reader.isOpen()) ) return;
+
+		// always keep the newest frame
+		while( memoryUsed > memoryBudget && inMemory.size() > 1 ){
+
+			int i = inMemory.front();
+			inMemory.pop_front();
+
+			memoryUsed -= frames[i]->getMemorySize();
+
+			delete frames[i];
+			frames[i] = NULL;
+		}
+	}
+
+	// the file the frames are written to (see ExtractionCache::beginSave)
+	ShapeSequenceWriter writer;
+	ShapeSequenceReader reader;
+	int fd;
+
+	string finishedPath; // the finished file, to read ahead from
+	FramePrefetcher prefetcher;
+	int lookahead;
+
+	vector<ShapeCollection*> frames; // NULL when the frame isn't in memory
+	deque<int> inMemory; // the frames in memory, oldest first
+	uint64_t memoryBudget;
+	uint64_t memoryUsed;
+};
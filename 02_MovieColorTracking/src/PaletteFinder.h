@@ -0,0 +1,284 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "FrameRegion.h"
+#include <float.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// suggests colors to track by finding the dominant colors in a movie
+// pixels are sampled at random from frames spread across the movie, then grouped with
+// mini-batch k-means (Sculley, "Web-Scale K-Means Clustering", 2010): each step moves the
+// centers toward a small random batch of samples, so it's quick even with lots of samples
+// each color comes with a threshold that covers most of the pixels that were grouped with it
+
+class PaletteFinder {
+
+public:
+
+	//--------------------------------------------------------------
+
+	PaletteFinder(){
+
+		numColors = 8;
+		samplesPerFrame = 2000;
+		batchSize = 1024;
+		numIterations = 200;
+		coverage = 0.9;
+	}
+
+	//--------------------------------------------------------------
+
+	void clear(){
+
+		sampleR.clear();
+		sampleG.clear();
+		sampleB.clear();
+
+		colors.clear();
+		thresholds.clear();
+		shares.clear();
+	}
+
+	//--------------------------------------------------------------
+
+	// take some random pixels from the region of a frame that's tracked
+	// (the black bars & the areas that are left out would only add colors that are never tracked)
+
+	void addFrame(ofPixels & pixels, FrameRegion & region){
+
+		unsigned char * pix = pixels.getPixels();
+		int numPix = region.width * region.height;
+		int channels = pixels.getNumChannels();
+
+		if( numPix == 0 ) return;
+
+		for(int i=0; i<samplesPerFrame; i++){
+
+			int sample = MIN(numPix - 1, (int)ofRandom(numPix));
+
+			if( region.isMasked(sample) ) continue;
+
+			int posInMem = ((region.y + sample / region.width) * pixels.getWidth() + region.x + sample % region.width) * channels;
+
+			sampleR.push_back(pix[posInMem]);
+			sampleG.push_back(pix[posInMem+1]);
+			sampleB.push_back(pix[posInMem+2]);
+		}
+	}
+
+	int getNumSamples(){
+
+		return sampleR.size();
+	}
+
+	//--------------------------------------------------------------
+
+	// group the samples into colors
+
+	void findPalette(){
+
+		colors.clear();
+		thresholds.clear();
+		shares.clear();
+
+		int numSamples = sampleR.size();
+
+		if( numSamples < numColors ) return;
+
+		chooseStartingCenters();
+
+		// move the centers toward random batches of samples
+		// each center moves less the more samples it has seen
+		vector<int> counts(numColors, 0);
+		vector<int> batch(batchSize);
+		vector<int> nearest(batchSize);
+		float dist;
+
+		for(int i=0; i<numIterations; i++){
+
+			for(int j=0; j<batchSize; j++){
+
+				batch[j] = MIN(numSamples - 1, (int)ofRandom(numSamples));
+				nearest[j] = findNearest(sampleR[batch[j]], sampleG[batch[j]], sampleB[batch[j]], dist);
+			}
+
+			for(int j=0; j<batchSize; j++){
+
+				int c = nearest[j];
+				counts[c]++;
+
+				float rate = 1.0 / counts[c];
+
+				centerR[c] += (sampleR[batch[j]] - centerR[c]) * rate;
+				centerG[c] += (sampleG[batch[j]] - centerG[c]) * rate;
+				centerB[c] += (sampleB[batch[j]] - centerB[c]) * rate;
+			}
+		}
+
+		// group every sample with its center
+		vector< vector<float> > distances(numColors);
+
+		for(int i=0; i<numSamples; i++){
+
+			int c = findNearest(sampleR[i], sampleG[i], sampleB[i], dist);
+			distances[c].push_back(dist);
+		}
+
+		// most common colors first
+		vector< pair<int, int> > order;
+
+		for(int c=0; c<numColors; c++){
+
+			order.push_back(make_pair(-(int)distances[c].size(), c));
+		}
+
+		sort(order.begin(), order.end());
+
+		for(int i=0; i<numColors; i++){
+
+			int c = order[i].second;
+
+			if( distances[c].size() == 0 ) continue;
+
+			colors.push_back(ofColor(centerR[c], centerG[c], centerB[c]));
+			shares.push_back((float)distances[c].size() / numSamples);
+
+			// the trackers match when the squared distance is less than the threshold cubed
+			vector<float>::iterator covered = distances[c].begin() + (int)((distances[c].size() - 1) * coverage);
+			nth_element(distances[c].begin(), covered, distances[c].end());
+
+			thresholds.push_back(ofClamp(ceil(pow(*covered, 1.0f / 3.0f)), 1, 255));
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// start the centers far apart (k-means++): each one is a sample picked at random,
+	// more likely the further it is from the centers we already have
+
+	void chooseStartingCenters(){
+
+		int numSamples = sampleR.size();
+
+		// pad to a multiple of 4 so SSE can do 4 at a time
+		// the centers that haven't been chosen yet (& the padding) are too far away to ever be nearest
+		int numPadded = (numColors + 3) / 4 * 4;
+
+		centerR.assign(numPadded, 1e9);
+		centerG.assign(numPadded, 1e9);
+		centerB.assign(numPadded, 1e9);
+
+		int first = MIN(numSamples - 1, (int)ofRandom(numSamples));
+		centerR[0] = sampleR[first];
+		centerG[0] = sampleG[first];
+		centerB[0] = sampleB[first];
+
+		vector<float> nearestDist(numSamples);
+
+		for(int c=1; c<numColors; c++){
+
+			// only the centers chosen so far count
+			float total = 0;
+
+			for(int i=0; i<numSamples; i++){
+
+				findNearest(sampleR[i], sampleG[i], sampleB[i], nearestDist[i], c);
+				total += nearestDist[i];
+			}
+
+			float pick = ofRandom(total);
+			int chosen = numSamples - 1;
+
+			for(int i=0; i<numSamples; i++){
+
+				pick -= nearestDist[i];
+
+				if( pick <= 0 ){
+
+					chosen = i;
+					break;
+				}
+			}
+
+			centerR[c] = sampleR[chosen];
+			centerG[c] = sampleG[chosen];
+			centerB[c] = sampleB[chosen];
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// find the nearest of the first numCenters centers (all of them by default)
+
+	int findNearest(float r, float g, float b, float & nearestDist, int numCenters = -1){
+
+		if( numCenters < 0 ) numCenters = numColors;
+
+		int nearest = 0;
+		nearestDist = FLT_MAX;
+
+		int i = 0;
+
+#ifdef __SSE__
+		__m128 vr = _mm_set1_ps(r);
+		__m128 vg = _mm_set1_ps(g);
+		__m128 vb = _mm_set1_ps(b);
+
+		for( ; i < numCenters; i += 4){
+
+			__m128 dr = _mm_sub_ps(_mm_loadu_ps(&centerR[i]), vr);
+			__m128 dg = _mm_sub_ps(_mm_loadu_ps(&centerG[i]), vg);
+			__m128 db = _mm_sub_ps(_mm_loadu_ps(&centerB[i]), vb);
+
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+			float dists[4];
+			_mm_storeu_ps(dists, d);
+
+			for(int j=0; j<4; j++){
+
+				if( dists[j] < nearestDist ){
+
+					nearestDist = dists[j];
+					nearest = i + j;
+				}
+			}
+		}
+#endif
+
+		for( ; i < numCenters; i++){
+
+			float dr = centerR[i] - r;
+			float dg = centerG[i] - g;
+			float db = centerB[i] - b;
+			float d = dr * dr + dg * dg + db * db;
+
+			if( d < nearestDist ){
+
+				nearestDist = d;
+				nearest = i;
+			}
+		}
+
+		return nearest;
+	}
+
+	int numColors;
+	int samplesPerFrame;
+	int batchSize;
+	int numIterations;
+	float coverage; // how many of a color's pixels its threshold should match (0-1)
+
+	// the results, most common first
+	vector<ofColor> colors;
+	vector<int> thresholds;
+	vector<float> shares;
+
+	// samples & centers are kept as separate arrays of r, g & b for SSE
+	vector<float> sampleR, sampleG, sampleB;
+	vector<float> centerR, centerG, centerB;
+};
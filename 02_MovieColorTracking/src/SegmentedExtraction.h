@@ -0,0 +1,552 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeExtractor.h"
+#include "ShapeTracker.h"
+#include "FrameFingerprint.h"
+#include "FrameStore.h"
+#include "ShapeSequenceFile.h"
+#include "NumCores.h"
+
+// finds the shapes in one piece of a movie on its own thread
+// it has its own movie player (without a texture), extractor & tracker, so nothing is shared
+// the movie is opened, decoded & closed on the segment's thread and nothing else touches it
+// (a QuickTime movie can only be used on the thread it was opened on)
+// until the frames before the piece have all been taken, its frames are saved into a part file
+// of its own instead of being kept in memory, then they're read back in order when it's its turn
+
+class ExtractionSegment : public ofThread {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ExtractionSegment(){
+
+		numDone = 0;
+		numRepeated = 0;
+		numSpilled = 0;
+		numRead = 0;
+		bOpening = false;
+		bOpened = false;
+		bStreaming = true;
+	}
+
+	~ExtractionSegment(){
+
+		stop();
+
+		// the part file is only needed until its frames have been taken
+		if( !partPath.empty() ){
+
+			writer.close();
+			partReader.close();
+			ofFile::removeFile(partPath);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// start the segment's thread, which opens the movie & finds the shapes from frame first up to last
+	// the frames are saved into the part file until they're taken (without one they're kept in memory)
+
+	void setup(string moviePath, int first, int last, ShapeExtractor & settings, int seed, string filePath = ""){
+
+		firstFrame = first;
+		lastFrame = last;
+		renderSeed = seed;
+		path = moviePath;
+		partPath = filePath;
+		bOpening = true;
+		bOpened = false;
+
+		extractor.copySettings(settings);
+
+		frames.clear();
+		lastFingerprint.clear();
+		lastShapes = ShapeCollection();
+
+		numSpilled = 0;
+		numRead = 0;
+		bStreaming = partPath.empty();
+
+		if( !bStreaming && !writer.open(partPath) ){
+
+			ofLog(OF_LOG_WARNING, "Failed to create " + partPath + ", keeping the frames in memory");
+			bStreaming = true;
+		}
+
+		startThread(false, false);
+	}
+
+	//--------------------------------------------------------------
+
+	// wait for the segment's thread to open the movie, returns false if it couldn't
+
+	bool waitUntilOpen(){
+
+		while( true ){
+
+			{
+				ofScopedLock lock(mutex);
+				if( !bOpening ) return bOpened;
+			}
+
+			ofSleepMillis(1);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void stop(){
+
+		if( isThreadRunning() ){
+
+			stopThread();
+			waitForThread(false);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void threadedFunction(){
+
+		movie.setUseTexture(false);
+
+		bool bLoaded = movie.loadMovie(path);
+
+		if( bLoaded ) extractor.setup(movie.getWidth(), movie.getHeight(), false);
+
+		{
+			ofScopedLock lock(mutex);
+			bOpening = false;
+			bOpened = bLoaded;
+		}
+
+		if( !bLoaded ) return;
+
+		// start from the frame before the segment, so a segment that starts on a repeat
+		// gets that frame's shapes again instead of finding them from scratch
+		// (the ids still start again, they're only joined up afterwards, see ShapeStitcher)
+		if( firstFrame > 0 ){
+
+			movie.setFrame(firstFrame - 1);
+			movie.update();
+
+			lastFingerprint.set(movie.getPixelsRef());
+			extractor.extract(movie.getPixelsRef(), lastShapes, renderSeed + firstFrame - 1);
+			tracker.track(lastShapes);
+		}
+
+		for(int frame=firstFrame; frame<lastFrame && isThreadRunning(); frame++){
+
+			movie.setFrame(frame);
+			movie.update();
+
+			ofPixels & pixels = movie.getPixelsRef();
+
+			// a frame that's the same as the last one we found shapes in gets the same shapes
+			fingerprint.set(pixels);
+
+			bool bRepeated = fingerprint.matches(lastFingerprint);
+
+			if( !bRepeated ){
+
+				lastFingerprint.swap(fingerprint);
+
+				lastShapes = ShapeCollection();
+				extractor.extract(pixels, lastShapes, renderSeed + frame);
+				tracker.track(lastShapes);
+			}
+
+			ofScopedLock lock(mutex);
+
+			lastShapes.bRepeated = bRepeated;
+
+			if( bStreaming ) frames.push_back(lastShapes);
+			else writer.addFrame(lastShapes);
+
+			if( bRepeated ) numRepeated++;
+			numDone++;
+		}
+
+		movie.close();
+	}
+
+	//--------------------------------------------------------------
+
+	// it's this segment's turn, stop saving frames into the part file & read back the ones in it
+	// (only called from the main thread)
+
+	void startStreaming(){
+
+		{
+			ofScopedLock lock(mutex);
+
+			if( bStreaming ) return;
+
+			numSpilled = writer.getNumFrames();
+			writer.close();
+			bStreaming = true;
+		}
+
+		// (if it can't be read the frames come back empty, so the frames after them stay in place)
+		if( !partReader.open(partPath) ) ofLog(OF_LOG_ERROR, "Failed to read back " + partPath);
+	}
+
+	//--------------------------------------------------------------
+
+	// take the frames that are finished so far, the ones in the part file first
+	// (those are read back a few at a time, so one update isn't spent reading the whole file)
+
+	void takeFrames(deque<ShapeCollection> & ready, int maxFromFile = 100){
+
+		startStreaming();
+
+		while( numRead < numSpilled && ready.size() < maxFromFile ){
+
+			ready.push_back(ShapeCollection());
+			partReader.getFrame(numRead++, ready.back());
+		}
+
+		if( hasFramesInFile() ) return;
+
+		if( partReader.isOpen() ){
+
+			partReader.close();
+			ofFile::removeFile(partPath);
+		}
+
+		ofScopedLock lock(mutex);
+
+		if( ready.empty() ){
+
+			ready.swap(frames);
+
+		} else {
+
+			ready.insert(ready.end(), frames.begin(), frames.end());
+			frames.clear();
+		}
+	}
+
+	// are there still frames in the part file that haven't been taken?
+
+	bool hasFramesInFile(){
+
+		return numRead < numSpilled;
+	}
+
+	//--------------------------------------------------------------
+
+	int getNumDone(){
+
+		ofScopedLock lock(mutex);
+		return numDone;
+	}
+
+	int getNumRepeated(){
+
+		ofScopedLock lock(mutex);
+		return numRepeated;
+	}
+
+	bool isFinished(){
+
+		return getNumDone() == lastFrame - firstFrame;
+	}
+
+	int firstFrame;
+	int lastFrame;
+	int renderSeed;
+	string path;
+
+	// only touched on the segment's thread
+	ofVideoPlayer movie;
+	ShapeExtractor extractor;
+	ShapeTracker tracker;
+	FrameFingerprint fingerprint;
+	FrameFingerprint lastFingerprint;
+	ShapeCollection lastShapes;
+
+	// the frames that haven't been taken yet, lock before touching them
+	// they go into the part file until it's this segment's turn, then into frames
+	deque<ShapeCollection> frames;
+	string partPath;
+	ShapeSequenceWriter writer;
+	bool bStreaming;
+
+	// only touched on the main thread
+	ShapeSequenceReader partReader;
+	int numSpilled;
+	int numRead;
+
+	int numDone;
+	int numRepeated;
+	bool bOpening;
+	bool bOpened;
+};
+
+//--------------------------------------------------------------
+
+// joins pieces of a movie that were tracked separately, a frame at a time
+// every piece's ids start at 0, so they're given new ids that follow on from the pieces before,
+// & the shapes at the start of a piece are linked to the shapes at the end of the piece before it
+// the link only compares the two frames either side of the join, so it's a best guess: a shape
+// that a single run would have kept following can still get a new id at a join
+
+class ShapeStitcher {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ShapeStitcher(){
+
+		reset();
+	}
+
+	void reset(){
+
+		linker.reset();
+		nextId = 0;
+		bHasPrevious = false;
+		beginPart();
+	}
+
+	//--------------------------------------------------------------
+
+	void beginPart(){
+
+		newIds.clear();
+		bFirstFrame = true;
+	}
+
+	//--------------------------------------------------------------
+
+	// give a frame of the current piece its ids in the whole movie, frames have to be added in order
+
+	void addFrame(ShapeCollection & frame){
+
+		// track the first frame of the piece on from the last frame of the piece before
+		if( bFirstFrame && bHasPrevious ){
+
+			vector<int> partIds = frame.ids;
+
+			linker.nextId = nextId;
+			linker.track(frame);
+
+			for(int i=0; i<partIds.size(); i++){
+
+				newIds[partIds[i]] = frame.ids[i];
+			}
+
+			nextId = linker.nextId;
+			frame.ids = partIds;
+		}
+
+		bFirstFrame = false;
+
+		for(int i=0; i<frame.ids.size(); i++){
+
+			map<int, int>::iterator it = newIds.find(frame.ids[i]);
+
+			if( it == newIds.end() ) it = newIds.insert( make_pair(frame.ids[i], nextId++) ).first;
+
+			frame.ids[i] = it->second;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// the piece is finished, the next piece carries on from its last frame
+
+	void endPart(ShapeCollection & lastFrame){
+
+		linker.reset();
+		linker.setPrevious(lastFrame);
+		bHasPrevious = true;
+
+		beginPart();
+	}
+
+	// or from the last of the frames so far (frames is a vector or a FrameStore)
+
+	template <class Frames>
+	void endPart(Frames & frames){
+
+		if( frames.size() > 0 ){
+
+			endPart(frames.back());
+
+		} else {
+
+			beginPart();
+		}
+	}
+
+	ShapeTracker linker;
+	int nextId;
+	bool bHasPrevious;
+
+	map<int, int> newIds; // id in the piece -> id in the whole movie
+	bool bFirstFrame;
+};
+
+//--------------------------------------------------------------
+
+// finds the shapes in a movie on every core at once
+// each frame's shapes only depend on that frame, so the movie is split into as many pieces as
+// there are cores, one after another, and each piece is tracked on its own thread
+// the finished frames are taken from the pieces in order, so the start of the movie can be used
+// before the rest of it is done
+
+class SegmentedExtraction {
+
+public:
+
+	//--------------------------------------------------------------
+
+	SegmentedExtraction(){
+
+		nextSegment = 0;
+	}
+
+	~SegmentedExtraction(){
+
+		clear();
+	}
+
+	//--------------------------------------------------------------
+
+	// every segment after the first saves its frames into a part file named partPrefix_<first frame>.segment
+	// until it's its turn (so only one segment's frames are ever waiting in memory)
+	// with no prefix they're all kept in memory
+
+	bool start(string moviePath, int numFrames, int numSegments, ShapeExtractor & settings, int renderSeed, string partPrefix = ""){
+
+		clear();
+
+		numSegments = ofClamp(numSegments, 1, MAX(1, numFrames));
+
+		for(int i=0; i<numSegments; i++){
+
+			ExtractionSegment * segment = new ExtractionSegment();
+			segments.push_back(segment);
+
+			int first = numFrames * i / numSegments;
+			string partPath = ( i > 0 && !partPrefix.empty() ) ? partPrefix + "_" + ofToString(first) + ".segment" : "";
+
+			segment->setup(moviePath, first, numFrames * (i + 1) / numSegments, settings, renderSeed, partPath);
+		}
+
+		// the segments open their movies at the same time
+		for(int i=0; i<segments.size(); i++){
+
+			if( !segments[i]->waitUntilOpen() ){
+
+				ofLog(OF_LOG_ERROR, "Failed to open " + moviePath + " for segment " + ofToString(i));
+				clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	bool isRunning(){
+
+		return segments.size() > 0;
+	}
+
+	bool isFinished(){
+
+		for(int i=0; i<segments.size(); i++){
+
+			if( !segments[i]->isFinished() ) return false;
+		}
+
+		return true;
+	}
+
+	int getNumFramesDone(){
+
+		int numDone = 0;
+
+		for(int i=0; i<segments.size(); i++){
+
+			numDone += segments[i]->getNumDone();
+		}
+
+		return numDone;
+	}
+
+	int getNumRepeatedFrames(){
+
+		int numRepeated = 0;
+
+		for(int i=0; i<segments.size(); i++){
+
+			numRepeated += segments[i]->getNumRepeated();
+		}
+
+		return numRepeated;
+	}
+
+	//--------------------------------------------------------------
+
+	// move the frames that are ready onto the end of frames, in order, so they can be used
+	// while the rest of the movie is still being tracked
+	// returns true once every frame has been moved
+
+	bool takeFrames(FrameStore & frames){
+
+		while( nextSegment < segments.size() ){
+
+			ExtractionSegment * segment = segments[nextSegment];
+
+			// check before taking, so frames added in between aren't missed
+			bool bFinished = segment->isFinished();
+
+			deque<ShapeCollection> ready;
+			segment->takeFrames(ready);
+
+			for(int i=0; i<ready.size(); i++){
+
+				stitcher.addFrame(ready[i]);
+				frames.push_back(ready[i]);
+			}
+
+			if( !bFinished || segment->hasFramesInFile() ) return false;
+
+			stitcher.endPart(frames);
+			nextSegment++;
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// stop any segments that are still going
+
+	void clear(){
+
+		for(int i=0; i<segments.size(); i++){
+
+			delete segments[i];
+		}
+
+		segments.clear();
+
+		nextSegment = 0;
+		stitcher.reset();
+	}
+
+	vector<ExtractionSegment*> segments;
+	int nextSegment; // the first segment that still has frames to take
+	ShapeStitcher stitcher;
+};
@@ -9,6 +9,13 @@ public:
 	
 	//--------------------------------------------------------------
 	
+	ShapeCollection(){
+	
+		bRepeated = false;
+	}
+	
+	//--------------------------------------------------------------
+	
 	void addShape(ofxCvBlob & newShape){
 	
 		shapes.push_back(newShape);
@@ -23,13 +30,41 @@ public:
 	
 	//--------------------------------------------------------------
 	
+	// roughly how much memory the shapes take up, outlines & all
+	// the simpler outlines are only made when they're used, so they're counted as if they were there
+	// (all of them together are about as big as the full outline), that way the size never changes
+	
+	int getMemorySize(){
+		
+		int size = sizeof(ShapeCollection) + shapes.size() * (sizeof(ofxCvBlob) + sizeof(ofColor) + sizeof(int));
+		
+		for(int i=0; i<shapes.size(); i++){
+			
+			size += (numLevels - 1) * sizeof(vector<ofPoint>) + 2 * shapes[i].pts.size() * sizeof(ofPoint);
+		}
+		
+		return size;
+	}
+	
+	//--------------------------------------------------------------
+	
 	// draw the shape with some randomness
 	// rotate the shape, offset the x,y positions
+	// the random numbers are seeded, so the same seed always gives the same splatter
+	// scale is how big the shapes end up on screen, to pick how detailed their outlines are
+	// (pass levelCounts, numLevels long, to count how many shapes are drawn at each level)
 	
-	void drawSplatter(){
+	void drawSplatter(int seed, float scale = 1.0, vector<int> * levelCounts = NULL){
+		
+		ofSeedRandom(seed);
 		
 		for(int i=0; i<shapes.size(); i++){
 			
+			// pick the random values in a fixed order so they're repeatable
+			float angle = ofRandom(-30, 30);
+			float offsetX = ofRandom(-20, 20);
+			float offsetY = ofRandom(-20, 20);
+			
 			//in order to rotate around the center of the shape, we need to translate into its center
 			ofPushMatrix();
 			
@@ -37,7 +72,7 @@ public:
 			ofTranslate(shapes[i].boundingRect.width/2, shapes[i].boundingRect.height/2, 0);
 			
 			// then we can rotate
-			ofRotateZ(ofRandom(-30, 30));
+			ofRotateZ(angle);
 			
 			// then we translate back
 			ofTranslate(-shapes[i].boundingRect.x, -shapes[i].boundingRect.y, 0);
@@ -47,14 +82,19 @@ public:
 			ofSetColor(colors[i]);
 			
 			// slight random offset
-			ofTranslate(ofRandom(-20, 20), ofRandom(-20, 20), 0);
+			ofTranslate(offsetX, offsetY, 0);
 			
 			// loop thru the points and add them to the shape
 			ofBeginShape();
 			
-			for(int j=0; j<shapes[i].nPts; j++){
+			int level = pickLevel(i, scale);
+			if( levelCounts != NULL ) (*levelCounts)[level]++;
+			
+			vector<ofPoint> & outline = getOutline(i, level);
+			
+			for(int j=0; j<outline.size(); j++){
 			
-				ofVertex(shapes[i].pts[j]);
+				ofVertex(outline[j]);
 			}
 			
 			ofEndShape(true);
@@ -65,9 +105,45 @@ public:
 	
 	//--------------------------------------------------------------
 	
+	// get the outlines that drawSplatter() draws with the same seed
+	// the random rotation & offset are applied to the points themselves
+	// so they can be drawn somewhere other than openGL
+	
+	void getSplatterOutlines(int seed, vector< vector<ofPoint> > & outlines){
+		
+		ofSeedRandom(seed);
+		
+		outlines.resize(shapes.size());
+		
+		for(int i=0; i<shapes.size(); i++){
+			
+			// same random values, in the same order as drawSplatter()
+			float angle = ofRandom(-30, 30);
+			float offsetX = ofRandom(-20, 20);
+			float offsetY = ofRandom(-20, 20);
+			
+			// rotate around the center of the shape
+			ofPoint center = shapes[i].boundingRect.getCenter();
+			float cosAngle = cos(angle * DEG_TO_RAD);
+			float sinAngle = sin(angle * DEG_TO_RAD);
+			
+			outlines[i].resize(shapes[i].nPts);
+			
+			for(int j=0; j<shapes[i].nPts; j++){
+				
+				float x = shapes[i].pts[j].x + offsetX - center.x;
+				float y = shapes[i].pts[j].y + offsetY - center.y;
+				
+				outlines[i][j].set(center.x + x * cosAngle - y * sinAngle, center.y + x * sinAngle + y * cosAngle);
+			}
+		}
+	}
+	
+	//--------------------------------------------------------------
+	
 	// draw the shape normally
 	
-	void draw(){
+	void draw(float scale = 1.0, vector<int> * levelCounts = NULL){
 		
 		for(int i=0; i<shapes.size(); i++){
 			
@@ -75,9 +151,14 @@ public:
 			
 			ofBeginShape();
 			
-			for(int j=0; j<shapes[i].nPts; j++){
+			int level = pickLevel(i, scale);
+			if( levelCounts != NULL ) (*levelCounts)[level]++;
+			
+			vector<ofPoint> & outline = getOutline(i, level);
+			
+			for(int j=0; j<outline.size(); j++){
 				
-				ofVertex(shapes[i].pts[j]);
+				ofVertex(outline[j]);
 			}
 			
 			ofEndShape(true);
@@ -87,8 +168,10 @@ public:
 	//--------------------------------------------------------------
 	
 	// save our shape data from opencv's contourFinder 
+	// the outlines can be simplified for shapes that will be used at a smaller scale
+	// (a scale of 0 saves the full outlines)
 	
-	void saveShapeDataAsXml(string filePath){
+	void saveShapeDataAsXml(string filePath, float scale = 0){
 		
 		ofxXmlSettings xmlDoc;
 		
@@ -100,6 +183,7 @@ public:
 		for(int i=0; i<numShapes; i++){
 			
 			xmlDoc.addTag("shape");
+			if( i < ids.size() ) xmlDoc.addAttribute("shape", "id", ids[i], i);
 			xmlDoc.pushTag("shape", i);
 			
 			// add the color
@@ -113,14 +197,16 @@ public:
 			xmlDoc.addTag("points");
 			xmlDoc.pushTag("points");
 			
-			int numPoints = shapes[i].nPts;
+			int level = ( scale > 0 ) ? pickLevel(i, scale) : 0;
+			vector<ofPoint> & outline = getOutline(i, level);
+			int numPoints = outline.size();
 			
 			for(int j=0; j<numPoints; j++){
 				
 				// save the points as attributes
 				xmlDoc.addTag("point");
-				xmlDoc.addAttribute("point", "x", shapes[i].pts[j].x, j);
-				xmlDoc.addAttribute("point", "y", shapes[i].pts[j].y, j);
+				xmlDoc.addAttribute("point", "x", outline[j].x, j);
+				xmlDoc.addAttribute("point", "y", outline[j].y, j);
 			}
 			
 			xmlDoc.popTag();
@@ -132,6 +218,162 @@ public:
 		// ofLogNotice("Saved xml file");
 	}
 	
+	//--------------------------------------------------------------
+	
+	// levels of detail
+	// level 0 is the full outline, each level after that is simplified twice as much
+	
+	static const int numLevels = 5;
+	
+	float getLevelTolerance(int level){
+		
+		return ( level == 0 ) ? 0 : 0.5 * (1 << (level - 1));
+	}
+	
+	vector<ofPoint> & getOutline(int i, int level){
+		
+		if( level == 0 ) return shapes[i].pts;
+		
+		// the simpler versions of the outline are only made the first time they're used
+		// (frames read back from a file are usually drawn once at one level, so the rest are never needed)
+		if( levels.size() < shapes.size() ) levels.resize(shapes.size());
+		if( levels[i].size() == 0 ) levels[i].resize(numLevels - 1);
+		
+		vector<ofPoint> & outline = levels[i][level - 1];
+		
+		// each level is simplified from the one before it
+		if( outline.size() == 0 ) simplifyOutline(getOutline(i, level - 1), getLevelTolerance(level), outline);
+		
+		return outline;
+	}
+	
+	//--------------------------------------------------------------
+	
+	// pick the simplest outline that's still within half a pixel when drawn at this scale
+	// shapes that only cover a few pixels get the simplest outline
+	
+	int pickLevel(int i, float scale){
+		
+		int level = 0;
+		float projectedSize = MAX(shapes[i].boundingRect.width, shapes[i].boundingRect.height) * scale;
+		
+		if( projectedSize < 4 ){
+			
+			level = numLevels - 1;
+			
+		} else {
+			
+			while( level + 1 < numLevels && getLevelTolerance(level + 1) * scale <= 0.5 ){
+				
+				level++;
+			}
+		}
+		
+		return level;
+	}
+	
+	//--------------------------------------------------------------
+	
+	// simplify a closed outline (Douglas-Peucker)
+	// keep the points that are further than the tolerance from the line between the points kept around them
+	
+	static void simplifyOutline(vector<ofPoint> & points, float tolerance, vector<ofPoint> & simplified){
+		
+		simplified.clear();
+		
+		int numPts = points.size();
+		
+		if( numPts < 4 ){
+			
+			simplified = points;
+			return;
+		}
+		
+		// split the outline at the first point & the point furthest from it
+		int furthest = 0;
+		float furthestDist = 0;
+		
+		for(int i=1; i<numPts; i++){
+			
+			float dist = points[0].squareDistance(points[i]);
+			
+			if( dist > furthestDist ){
+				
+				furthestDist = dist;
+				furthest = i;
+			}
+		}
+		
+		vector<bool> keep(numPts, false);
+		keep[0] = keep[furthest] = true;
+		
+		// work thru the spans with a stack instead of recursion
+		vector< pair<int, int> > spans;
+		spans.push_back( make_pair(0, furthest) );
+		spans.push_back( make_pair(furthest, numPts) );
+		
+		float toleranceSq = tolerance * tolerance;
+		
+		while( spans.size() > 0 ){
+			
+			int first = spans.back().first;
+			int last = spans.back().second;
+			spans.pop_back();
+			
+			ofPoint & a = points[first];
+			ofPoint & b = points[last % numPts];
+			ofPoint line = b - a;
+			float lineLengthSq = line.x * line.x + line.y * line.y;
+			
+			int worst = -1;
+			float worstDistSq = toleranceSq;
+			
+			for(int i=first+1; i<last; i++){
+				
+				// squared distance from the point to the line
+				ofPoint d = points[i] - a;
+				float distSq;
+				
+				if( lineLengthSq == 0 ){
+					
+					distSq = d.x * d.x + d.y * d.y;
+					
+				} else {
+					
+					float cross = line.x * d.y - line.y * d.x;
+					distSq = cross * cross / lineLengthSq;
+				}
+				
+				if( distSq > worstDistSq ){
+					
+					worstDistSq = distSq;
+					worst = i;
+				}
+			}
+			
+			if( worst >= 0 ){
+				
+				keep[worst] = true;
+				spans.push_back( make_pair(first, worst) );
+				spans.push_back( make_pair(worst, last) );
+			}
+		}
+		
+		for(int i=0; i<numPts; i++){
+			
+			if( keep[i] ) simplified.push_back(points[i]);
+		}
+	}
+	
 	vector<ofxCvBlob> shapes;
 	vector<ofColor> colors;
+	
+	// the same shape has the same id from frame to frame (see ShapeTracker)
+	vector<int> ids;
+	
+	// the movie frame was the same as the one before, so these are that frame's shapes again
+	bool bRepeated;
+	
+	// the simplified outlines of each shape (levels 1 and up, empty until they're used, see getOutline)
+	vector< vector< vector<ofPoint> > > levels;
 };
\ No newline at end of file
@@ -0,0 +1,271 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ShapeCollection.h"
+#include "FrameRegion.h"
+
+// finds the shapes of one color in a frame
+// everything it works with is its own (even its random numbers), so each thread can have one
+// the colors of the shapes are sampled at random, seeding with the frame number means the same
+// frame always gets the same shapes, whichever thread it's found on
+// only the pixels in the region are looked at (see FrameRegion), the map is only as big as the region
+
+class ShapeExtractor {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ShapeExtractor(){
+
+		threshold = 13;
+		blurSize = 5;
+		minShapeArea = 5;
+		maxShapeArea = 0;
+		maxShapes = 20000;
+		randomState = 1;
+	}
+
+	//--------------------------------------------------------------
+
+	// off the main thread the map can't have a texture
+	// (& the app doesn't give it one either, it only uploads the map when it's drawn)
+
+	void setup(int width, int height, bool bUseTexture = true){
+
+		region.setup(width, height);
+
+		colorMap.setUseTexture(bUseTexture);
+		colorMap.allocate(region.width, region.height);
+
+		// no limit on the size of a shape
+		if( maxShapeArea == 0 ) maxShapeArea = width * 2 * height;
+	}
+
+	//--------------------------------------------------------------
+
+	// copy the settings that change the shapes from another extractor
+
+	void copySettings(ShapeExtractor & other){
+
+		searchColor = other.searchColor;
+		threshold = other.threshold;
+		blurSize = other.blurSize;
+		minShapeArea = other.minShapeArea;
+		maxShapeArea = other.maxShapeArea;
+		maxShapes = other.maxShapes;
+		region = other.region;
+	}
+
+	//--------------------------------------------------------------
+
+	// add the settings that change the shapes to a cache key (the app & the batch share it, so they find each other's shapes)
+	// the threshold & blur are passed in, so a sweep can key its settings the same way
+
+	template <class Key>
+	void addToKey(Key & key, int thresh, int blur, int seed){
+
+		key.addValue(searchColor.r);
+		key.addValue(searchColor.g);
+		key.addValue(searchColor.b);
+		key.addValue(thresh);
+		key.addValue(blur);
+		key.addValue(minShapeArea);
+		key.addValue(maxShapeArea);
+		key.addValue(maxShapes);
+		key.addValue(seed);
+		region.addToKey(key);
+	}
+
+	//--------------------------------------------------------------
+
+	// find the shapes in a frame with the current settings
+
+	void extract(ofPixels & pixels, ShapeCollection & frameShapes, int seed){
+
+		findColorDistances(pixels);
+		thresholdColorDistances(threshold, blurSize);
+		extractShapes(pixels, frameShapes, seed);
+	}
+
+	//--------------------------------------------------------------
+
+	// find how far every pixel's color in the region is from the search color (squared)
+
+	void findColorDistances(ofPixels & pixels){
+
+		// get a pointer to the pixel array for the search image
+		unsigned char * pix = pixels.getPixels();
+
+		// figure out the # of channels
+		int channels = pixels.getNumChannels();
+
+		colorDistances.resize(region.width * region.height);
+
+		for(int j=0; j<region.height; j++){
+
+			// the start of the row in the frame
+			unsigned char * row = pix + ((j + region.y) * pixels.getWidth() + region.x) * channels;
+
+			for(int i=0; i<region.width; i++){
+
+				int posInMem = i * channels;
+
+				// get the difference
+				int diffR = searchColor.r - row[posInMem];
+				int diffG = searchColor.g - row[posInMem+1];
+				int diffB = searchColor.b - row[posInMem+2];
+
+				// get the distance
+				colorDistances[j * region.width + i] = ( diffR * diffR ) + ( diffG * diffG ) + ( diffB * diffB );
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// turn the color distances into a map of matching pixels
+
+	void thresholdColorDistances(int thresh, int blur){
+
+		unsigned char * mapPix = colorMap.getPixels();
+
+		// calculate the minimum distance to be considered a matching color
+		int minDist = thresh * thresh * thresh;
+
+		for(int i=0; i<colorDistances.size(); i++){
+
+			// set to black or white depending on the difference
+			mapPix[i] = ( colorDistances[i] < minDist ) ? 255 : 0;
+		}
+
+		// update the pixels
+		colorMap.setFromPixels(mapPix, colorMap.getWidth(), colorMap.getHeight());
+
+		// do a little blurring & thresholding to smooth out the edges
+		colorMap.blur(blur);
+		colorMap.threshold(128);
+
+		// the blur can spread into the areas that are left out
+		region.applyMask(colorMap);
+	}
+
+	//--------------------------------------------------------------
+
+	// use opencv's contour finder to get the outlines from the map
+
+	void extractShapes(ofPixels & pixels, ShapeCollection & frameShapes, int seed){
+
+		seedRandom(seed);
+
+		contourFinder.findContours(colorMap, minShapeArea, maxShapeArea, maxShapes, true, false);
+
+		// get the shape count
+		int numShapes = contourFinder.nBlobs;
+
+		for(int i=0; i<numShapes; i++){
+
+			// copy all of the shape data over to a new cvBlob
+			ofxCvBlob newBlob;
+			newBlob.nPts = contourFinder.blobs[i].nPts;
+			newBlob.pts.insert(newBlob.pts.begin(), contourFinder.blobs[i].pts.begin(), contourFinder.blobs[i].pts.end());
+			newBlob.boundingRect = contourFinder.blobs[i].boundingRect;
+			region.moveToFrame(newBlob);
+			frameShapes.addShape(newBlob);
+
+			// get the color
+			ofColor shapeColor = getColorOfShape(contourFinder.blobs[i], pixels);
+			frameShapes.addColor(shapeColor);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// this is one of many ways to grab the color from a blob
+	// it's actually a very fast and not-so accurate way to do so
+	// we're grabbing 5 random colors and averaging them
+	// but we need make sure that the randomly selected colors are from those
+	// pixels that match the search color (which are the white pixels
+	// saved in the cvImage colorMap)
+	// the shape is where it was found in the map, not in the frame
+
+	ofColor getColorOfShape(ofxCvBlob & shape, ofPixels & pixels){
+
+		ofColor results;
+		ofRectangle searchRect = shape.boundingRect;
+
+		unsigned char * mapPix = colorMap.getPixels();
+		unsigned char * pix = pixels.getPixels();
+
+		int sumR = 0;
+		int sumG = 0;
+		int sumB = 0;
+
+		int pixFound = 0;
+
+		while( pixFound < 5 ){
+
+			// randomly look in the blob area for a white color
+			int randX = searchRect.x + random(searchRect.width);
+			int randY = searchRect.y + random(searchRect.height);
+			int memPos = randY * colorMap.getWidth() + randX;
+
+			// if the map pixel is white
+			if( mapPix[memPos] == 255 ){
+
+				// find the pixel in the frame & mult by 3 (because it's a color source)
+				memPos = ((randY + region.y) * pixels.getWidth() + randX + region.x) * 3;
+
+				// get the RGB values
+				sumR += pix[memPos];
+				sumG += pix[memPos+1];
+				sumB += pix[memPos+2];
+
+				pixFound++;
+			}
+		}
+
+		// update the color with the average values
+		results.r = sumR/pixFound;
+		results.g = sumG/pixFound;
+		results.b = sumB/pixFound;
+
+		return results;
+	}
+
+	//--------------------------------------------------------------
+
+	// ofRandom shares one generator between every thread, so use our own (xorshift)
+
+	void seedRandom(int seed){
+
+		randomState = (unsigned int)seed * 2654435761u;
+
+		if( randomState == 0 ) randomState = 1;
+	}
+
+	float random(float max){
+
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+
+		return max * (randomState / 4294967296.0f);
+	}
+
+	// the settings that change the shapes
+	ofColor searchColor;
+	int threshold;
+	int blurSize;
+	int minShapeArea;
+	int maxShapeArea;
+	int maxShapes;
+	FrameRegion region;
+
+	vector<int> colorDistances;
+	ofxCvGrayscaleImage colorMap;
+	ofxCvContourFinder contourFinder;
+	unsigned int randomState;
+};
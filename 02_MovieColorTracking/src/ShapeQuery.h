@@ -0,0 +1,203 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeSequenceFile.h"
+
+#include <float.h>
+
+// what a shape has to be like to be found (see ShapeQuery)
+// by default every shape matches
+
+struct ShapeFilter {
+
+	ShapeFilter(){
+
+		minArea = 0;
+		maxArea = FLT_MAX;
+		maxColorDistance = -1;
+	}
+
+	//--------------------------------------------------------------
+
+	// could any of a frame's shapes match? (from the frame's summary in the index)
+
+	bool mightMatch(ShapeSequenceIndexEntry & summary){
+
+		if( summary.numShapes == 0 ) return false;
+		if( summary.maxArea < minArea || summary.minArea > maxArea ) return false;
+
+		if( maxColorDistance >= 0 ){
+
+			// how far the color is from the nearest color inside the frame's range of colors
+			float distance = 0;
+
+			for(int c=0; c<3; c++){
+
+				float nearest = ofClamp(color[c], summary.minColor[c], summary.maxColor[c]);
+				distance += (color[c] - nearest) * (color[c] - nearest);
+			}
+
+			if( distance > maxColorDistance * maxColorDistance ) return false;
+		}
+
+		ofRectangle bounds(summary.bounds[0], summary.bounds[1], summary.bounds[2], summary.bounds[3]);
+
+		return overlapsRegion(bounds);
+	}
+
+	//--------------------------------------------------------------
+
+	bool matches(ofColor & shapeColor, ofRectangle & boundingRect, float area){
+
+		if( area < minArea || area > maxArea ) return false;
+
+		if( maxColorDistance >= 0 ){
+
+			float diffR = shapeColor.r - color.r;
+			float diffG = shapeColor.g - color.g;
+			float diffB = shapeColor.b - color.b;
+
+			if( diffR * diffR + diffG * diffG + diffB * diffB > maxColorDistance * maxColorDistance ) return false;
+		}
+
+		return overlapsRegion(boundingRect);
+	}
+
+	//--------------------------------------------------------------
+
+	bool overlapsRegion(ofRectangle & rect){
+
+		if( region.width <= 0 || region.height <= 0 ) return true;
+
+		return rect.x <= region.x + region.width && rect.x + rect.width >= region.x
+			&& rect.y <= region.y + region.height && rect.y + rect.height >= region.y;
+	}
+
+	// the area inside the shape's outline, in pixels
+	float minArea;
+	float maxArea;
+
+	// how far (in rgb) the shape's color can be from color (less than 0 for any color)
+	ofColor color;
+	float maxColorDistance;
+
+	// the shape's bounding rect has to overlap this (an empty rect for anywhere)
+	ofRectangle region;
+};
+
+//--------------------------------------------------------------
+
+// a shape that was found
+
+struct ShapeMatch {
+
+	int frame;
+	int index; // in the frame
+	int id;
+	ofColor color;
+	float area;
+	ofxCvBlob shape;
+};
+
+//--------------------------------------------------------------
+
+// finds the shapes in a range of frames of a shape sequence that match a filter
+// frames that can't have a match are skipped using the summaries in the index,
+// & in the rest only the shapes that match are read
+
+class ShapeQuery {
+
+public:
+
+	//--------------------------------------------------------------
+
+	bool open(string filePath){
+
+		return reader.open(filePath);
+	}
+
+	int getNumFrames(){
+
+		return reader.getNumFrames();
+	}
+
+	//--------------------------------------------------------------
+
+	// find the shapes that match from frame first to frame last (including it)
+	// returns how many were found
+
+	int findShapes(int first, int last, ShapeFilter & filter, vector<ShapeMatch> & matches){
+
+		int numFound = 0;
+
+		first = MAX(first, 0);
+		last = MIN(last, reader.getNumFrames() - 1);
+
+		for(int frame=first; frame<=last; frame++){
+
+			ShapeSequenceIndexEntry summary = reader.getSummary(frame);
+
+			if( !filter.mightMatch(summary) ) continue;
+
+			for(int i=0; i<summary.numShapes; i++){
+
+				ShapeMatch match;
+				ofRectangle boundingRect;
+
+				reader.getShapeInfo(frame, i, match.color, match.id, boundingRect, match.area);
+
+				if( !filter.matches(match.color, boundingRect, match.area) ) continue;
+
+				match.frame = frame;
+				match.index = i;
+				reader.getShape(frame, i, match.shape);
+
+				matches.push_back(match);
+				numFound++;
+			}
+		}
+
+		return numFound;
+	}
+
+	//--------------------------------------------------------------
+
+	// or just find which frames have at least one shape that matches (no outlines are read)
+
+	int findFrames(int first, int last, ShapeFilter & filter, vector<int> & frames){
+
+		int numFound = 0;
+
+		first = MAX(first, 0);
+		last = MIN(last, reader.getNumFrames() - 1);
+
+		for(int frame=first; frame<=last; frame++){
+
+			ShapeSequenceIndexEntry summary = reader.getSummary(frame);
+
+			if( !filter.mightMatch(summary) ) continue;
+
+			for(int i=0; i<summary.numShapes; i++){
+
+				ofColor color;
+				int id;
+				ofRectangle boundingRect;
+				float area;
+
+				reader.getShapeInfo(frame, i, color, id, boundingRect, area);
+
+				if( filter.matches(color, boundingRect, area) ){
+
+					frames.push_back(frame);
+					numFound++;
+					break;
+				}
+			}
+		}
+
+		return numFound;
+	}
+
+	ShapeSequenceReader reader;
+};
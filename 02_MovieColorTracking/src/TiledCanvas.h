@@ -0,0 +1,362 @@
+
+#pragma once
+
+#include "ofMain.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// a canvas that's too big to fit in a texture (or in memory) for print-size renders
+// the canvas is cut into square tiles that are stored in a file on disk
+// only a limited number of tiles are mapped into memory at once, the least recently used ones get unmapped
+// shapes are drawn on the CPU, one tile at a time
+
+class TiledCanvas {
+
+public:
+
+	//--------------------------------------------------------------
+
+	TiledCanvas(){
+
+		fileDescriptor = -1;
+		width = height = 0;
+		numTilesX = numTilesY = 0;
+	}
+
+	~TiledCanvas(){
+
+		close();
+	}
+
+	//--------------------------------------------------------------
+
+	// create the canvas & its file on disk
+	// every tile starts out filled with the paper color
+
+	bool setup(int w, int h, string filePath, ofColor paper, int tileSizeInPixels = 512, int maxTilesInMemory = 64){
+
+		close();
+
+		width = w;
+		height = h;
+		tileSize = tileSizeInPixels;
+		maxResidentTiles = MAX(1, maxTilesInMemory);
+		paperColor = paper;
+
+		numTilesX = (width + tileSize - 1) / tileSize;
+		numTilesY = (height + tileSize - 1) / tileSize;
+
+		// each tile is stored in a slot that starts on a memory page, so it can be mapped by itself
+		int pageSize = getpagesize();
+		tileBytes = tileSize * tileSize * 3;
+		slotBytes = ((tileBytes + pageSize - 1) / pageSize) * pageSize;
+
+		fileDescriptor = open(ofToDataPath(filePath).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+		if( fileDescriptor < 0 ){
+
+			ofLog(OF_LOG_ERROR, "Failed to create tiled canvas file " + filePath);
+			return false;
+		}
+
+		// the file is sparse, so untouched tiles don't take up any disk space
+		if( ftruncate(fileDescriptor, (off_t)numTilesX * numTilesY * slotBytes) != 0 ){
+
+			ofLog(OF_LOG_ERROR, "Failed to size tiled canvas file " + filePath);
+			close();
+			return false;
+		}
+
+		bTilePainted.assign(numTilesX * numTilesY, false);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// unmap all of the tiles and close the file
+
+	void close(){
+
+		while( residentOrder.size() > 0 ){
+
+			unmapTile(residentOrder.back());
+		}
+
+		if( fileDescriptor >= 0 ){
+
+			::close(fileDescriptor);
+			fileDescriptor = -1;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// get a tile's pixels (RGB, tileSize x tileSize), mapping it into memory if it isn't already
+
+	unsigned char * getTile(int tileX, int tileY){
+
+		int index = tileY * numTilesX + tileX;
+
+		map<int, unsigned char*>::iterator it = residentTiles.find(index);
+
+		if( it != residentTiles.end() ){
+
+			// move it to the front of the "recently used" list
+			residentOrder.remove(index);
+			residentOrder.push_front(index);
+
+			return it->second;
+		}
+
+		// make room for it
+		while( residentOrder.size() >= maxResidentTiles ){
+
+			unmapTile(residentOrder.back());
+		}
+
+		void * data = mmap(NULL, slotBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, (off_t)index * slotBytes);
+
+		if( data == MAP_FAILED ){
+
+			ofLog(OF_LOG_ERROR, "Failed to map canvas tile");
+			return NULL;
+		}
+
+		unsigned char * pix = (unsigned char*)data;
+
+		// fill tiles with paper the first time they're used
+		if( !bTilePainted[index] ){
+
+			for(int i=0; i<tileSize * tileSize; i++){
+
+				pix[i*3] = paperColor.r;
+				pix[i*3+1] = paperColor.g;
+				pix[i*3+2] = paperColor.b;
+			}
+
+			bTilePainted[index] = true;
+		}
+
+		residentTiles[index] = pix;
+		residentOrder.push_front(index);
+
+		return pix;
+	}
+
+	//--------------------------------------------------------------
+
+	// give a tile back to the file on disk
+
+	void unmapTile(int index){
+
+		map<int, unsigned char*>::iterator it = residentTiles.find(index);
+
+		if( it == residentTiles.end() ) return;
+
+		munmap(it->second, slotBytes);
+
+		residentTiles.erase(it);
+		residentOrder.remove(index);
+	}
+
+	//--------------------------------------------------------------
+
+	// draw filled shapes into the canvas
+	// the outlines are in source pixels, they're scaled up to the size of the canvas
+	// each shape is sorted into the tiles it covers, then each tile is drawn in turn
+	// that way each tile only needs to be in memory once
+
+	void drawShapes(vector< vector<ofPoint> > & outlines, vector<ofColor> & colors, float scale){
+
+		vector< vector<int> > bins(numTilesX * numTilesY);
+		vector<ofRectangle> bounds(outlines.size());
+
+		for(int i=0; i<outlines.size(); i++){
+
+			if( outlines[i].size() < 3 ) continue;
+
+			// get the scaled bounding box
+			float minX = outlines[i][0].x, maxX = minX;
+			float minY = outlines[i][0].y, maxY = minY;
+
+			for(int j=1; j<outlines[i].size(); j++){
+
+				minX = MIN(minX, outlines[i][j].x);
+				maxX = MAX(maxX, outlines[i][j].x);
+				minY = MIN(minY, outlines[i][j].y);
+				maxY = MAX(maxY, outlines[i][j].y);
+			}
+
+			bounds[i].set(minX * scale, minY * scale, (maxX - minX) * scale, (maxY - minY) * scale);
+
+			// add it to every tile it touches
+			int firstTileX = ofClamp(floor(bounds[i].x / tileSize), 0, numTilesX - 1);
+			int lastTileX = ofClamp(floor((bounds[i].x + bounds[i].width) / tileSize), 0, numTilesX - 1);
+			int firstTileY = ofClamp(floor(bounds[i].y / tileSize), 0, numTilesY - 1);
+			int lastTileY = ofClamp(floor((bounds[i].y + bounds[i].height) / tileSize), 0, numTilesY - 1);
+
+			for(int ty=firstTileY; ty<=lastTileY; ty++){
+
+				for(int tx=firstTileX; tx<=lastTileX; tx++){
+
+					bins[ty * numTilesX + tx].push_back(i);
+				}
+			}
+		}
+
+		// draw the tiles, keeping the shapes in their original order within each tile
+		for(int index=0; index<bins.size(); index++){
+
+			if( bins[index].size() == 0 ) continue;
+
+			int tileX = index % numTilesX;
+			int tileY = index / numTilesX;
+			unsigned char * pix = getTile(tileX, tileY);
+
+			if( pix == NULL ) continue;
+
+			for(int k=0; k<bins[index].size(); k++){
+
+				int i = bins[index][k];
+				fillPolygon(pix, tileX * tileSize, tileY * tileSize, outlines[i], bounds[i], colors[i], scale);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// fill a polygon into one tile using scanlines (even-odd rule)
+	// the tile's top-left corner is at (originX, originY) on the canvas
+
+	void fillPolygon(unsigned char * pix, int originX, int originY, vector<ofPoint> & outline, ofRectangle & bound, ofColor & color, float scale){
+
+		int firstRow = MAX(0, (int)floor(bound.y) - originY);
+		int lastRow = MIN(tileSize - 1, (int)ceil(bound.y + bound.height) - originY);
+
+		// clip against the edge of the canvas too
+		lastRow = MIN(lastRow, height - 1 - originY);
+
+		int numPts = outline.size();
+		vector<float> crossings;
+
+		for(int row=firstRow; row<=lastRow; row++){
+
+			// sample in the middle of the pixel row
+			float y = (originY + row + 0.5) / scale;
+
+			crossings.clear();
+
+			for(int j=0; j<numPts; j++){
+
+				ofPoint & a = outline[j];
+				ofPoint & b = outline[(j + 1) % numPts];
+
+				if( (a.y <= y && b.y > y) || (b.y <= y && a.y > y) ){
+
+					float x = a.x + (y - a.y) / (b.y - a.y) * (b.x - a.x);
+					crossings.push_back(x * scale - originX);
+				}
+			}
+
+			sort(crossings.begin(), crossings.end());
+
+			unsigned char * rowPix = pix + row * tileSize * 3;
+
+			for(int c=0; c+1<crossings.size(); c+=2){
+
+				int startX = MAX(0, (int)ceil(crossings[c] - 0.5));
+				int endX = MIN(tileSize - 1, (int)ceil(crossings[c+1] - 0.5) - 1);
+				endX = MIN(endX, width - 1 - originX);
+
+				for(int x=startX; x<=endX; x++){
+
+					rowPix[x*3] = color.r;
+					rowPix[x*3+1] = color.g;
+					rowPix[x*3+2] = color.b;
+				}
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// write the canvas out as a binary PPM image, one row at a time
+	// this works for any size of canvas, most print & image tools can open these files
+	// a whole row of tiles is kept in memory while its rows are written, so each tile is only mapped once
+
+	bool saveAsPPM(string filePath){
+
+		FILE * file = fopen(ofToDataPath(filePath).c_str(), "wb");
+
+		if( file == NULL ){
+
+			ofLog(OF_LOG_ERROR, "Failed to save tiled canvas to " + filePath);
+			return false;
+		}
+
+		fprintf(file, "P6\n%i %i\n255\n", width, height);
+
+		// make room for a row of tiles (put back afterwards)
+		int maxTiles = maxResidentTiles;
+		maxResidentTiles = MAX(maxResidentTiles, numTilesX);
+
+		vector<unsigned char*> rowTiles(numTilesX);
+		bool bSaved = true;
+
+		for(int tileY=0; tileY<numTilesY && bSaved; tileY++){
+
+			for(int tileX=0; tileX<numTilesX; tileX++){
+
+				rowTiles[tileX] = getTile(tileX, tileY);
+
+				// the tile couldn't be mapped, there's nothing to save
+				if( rowTiles[tileX] == NULL ){
+
+					ofLog(OF_LOG_ERROR, "Failed to read a tile of the canvas, " + filePath + " is incomplete");
+					bSaved = false;
+					break;
+				}
+			}
+
+			int rowsInTile = MIN(tileSize, height - tileY * tileSize);
+
+			for(int row=0; row<rowsInTile && bSaved; row++){
+
+				for(int tileX=0; tileX<numTilesX; tileX++){
+
+					int colsInTile = MIN(tileSize, width - tileX * tileSize);
+					fwrite(rowTiles[tileX] + row * tileSize * 3, 3, colsInTile, file);
+				}
+			}
+		}
+
+		fclose(file);
+
+		maxResidentTiles = maxTiles;
+
+		while( residentOrder.size() > maxResidentTiles ){
+
+			unmapTile(residentOrder.back());
+		}
+
+		return bSaved;
+	}
+
+	int width;
+	int height;
+	int tileSize;
+	int numTilesX;
+	int numTilesY;
+	int tileBytes;
+	int slotBytes;
+	int maxResidentTiles;
+	ofColor paperColor;
+
+	int fileDescriptor;
+	vector<bool> bTilePainted;
+	map<int, unsigned char*> residentTiles;
+	list<int> residentOrder;
+};
@@ -7,26 +7,57 @@ void testApp::setup(){
 	
 	ofSetFrameRate(30);
 
-	// set our app mode
-	appMode = APP_MODE_TRACKING;
-	
 	// load movie 
 	// Selection from "Sprengung der Fliegerbombe / Schwabing, Mnchen / 28.8.2012"
 	// By Simon Aschenbrenner
 	// Available on Vimeo https://vimeo.com/48399328
-	source.loadMovie("Explosion.mov");
-	
-	// create a "map" texture to show the areas of matching color
-	colorMap.allocate(source.getWidth(), source.getHeight());
+	moviePath = "Explosion.mov";
+	source.loadMovie(moviePath);
 	
 	// create a window 2x as big as the image
 	ofSetWindowShape(source.getWidth()*2, source.getHeight());
 	
 	// set the color to search for 
-	searchColor.set( 225, 140, 60); 
+	extractor.searchColor.set( 225, 140, 60); 
 	
 	// how close should the color be to the picked color
-	matchThreshold = 13;
+	extractor.threshold = 13;
+	
+	// how the matching pixels are turned into shapes
+	extractor.blurSize = 5;
+	extractor.minShapeArea = 5;
+	extractor.maxShapeArea = source.getWidth() * 2 * source.getHeight();
+	extractor.maxShapes = 20000;
+	
+	// only look at part of the frame, if region.xml says so (see FrameRegion)
+	// & leave out the black bars if the movie is letterboxed
+	ofxXmlSettings regionXml;
+	
+	if( regionXml.loadFile("region.xml") ) extractor.region.loadSettings(regionXml);
+	if( extractor.region.bFindBars ) extractor.region.findBars(source);
+	
+	// create a "map" to find the areas of matching color, & textures to preview it
+	// tracking can go through many frames between draws, so the map has no texture of its own,
+	// the latest map (& movie frame) is only uploaded into the preview textures when it's drawn
+	// (the map is only as big as the region)
+	extractor.setup(source.getWidth(), source.getHeight(), false);
+	previewFrame.allocate(source.getWidth(), source.getHeight(), GL_RGB);
+	previewMap.allocate(extractor.region.width, extractor.region.height, GL_LUMINANCE);
+	
+	// track a piece of the movie on each core at once
+	// (set to 1 to watch the shapes being found frame by frame)
+	numSegments = getNumCores();
+	
+	// how long (in milliseconds) to spend tracking frames in each update when they're tracked here
+	trackingBudget = 25;
+	
+	// how much memory the frames' shapes can use, the rest are read back from the cache when they're used
+	// playing a finished movie streams its frames from the cache, reading a few frames ahead,
+	// so it only needs enough memory for a few frames
+	frameMemoryBudget = 1024 * 1024 * 1024;
+	playbackMemoryBudget = 16 * 1024 * 1024;
+	frames.setMemoryBudget(frameMemoryBudget);
+	frames.setLookahead(8);
 	
 	// current frame
 	currentFrame = 0;
@@ -34,40 +65,103 @@ void testApp::setup(){
 	// we haven't saved our data yet
 	bDataExtracted = false;
 	
+	// seed the random numbers so every run tracks & splatters the same way
+	// change the seed to get a different (but still repeatable) animation
+	renderSeed = 1;
+	ofSeedRandom(renderSeed);
+	
+	// how much bigger than the movie a print of the painting is
+	printScale = 8;
+	
+	// how many frames (spread across the movie) to sample when looking for a palette
+	paletteFrames = 100;
+	
 	// create a 'canvas' texture to accumulate shapes
 	canvas.allocate(source.getWidth(), source.getHeight(), GL_RGB);
+	clearCanvas();
+	
+	// and one to draw the keyframes in, away from the one on screen
+	keyframeCanvas.allocate(source.getWidth(), source.getHeight(), GL_RGB);
+	bBuildingKeyframes = false;
+	
+	// the shapes are cached by a hash of the movie file & every setting that changes them
+	// the movie is only hashed once, each search color & threshold adds to the same start
+	movieCache.reset();
+	movieCache.addFile(moviePath);
+	
+	startTracking();
 }
 
 //--------------------------------------------------------------
 
 void testApp::update(){
 
-	if( appMode == APP_MODE_TRACKING ){
+	// the pieces of the movie are tracked on their own threads
+	// pick up the frames they've finished, in order, whatever we're doing (we might be playing them already)
+	if( segmentedExtraction.isRunning() && segmentedExtraction.takeFrames(frames) ){
 		
-		// move to the current frame
-		source.setFrame(currentFrame);
-		source.update();
+		numRepeatedFrames = segmentedExtraction.getNumRepeatedFrames();
+		segmentedExtraction.clear();
 		
-		// look for the matching pixels & convert shapes to vectors
-		searchForColorInPixels( searchColor, source.getPixelsRef(), matchThreshold);
-		convertToVectors(colorMap);
-		 
-		// update the frame count
-		currentFrame++;
+		finishTracking();
+	}
+	
+	// take the keyframes a few frames at a time, whatever we're doing
+	// (rendering goes through every frame anyway, so it takes them itself)
+	if( bBuildingKeyframes && appMode != APP_MODE_RENDERING ) buildKeyframes();
+	
+	if( appMode == APP_MODE_TRACKING && !segmentedExtraction.isRunning() ){
 		
-		// if we're at the end of the movie, stop
-		if( currentFrame == source.getTotalNumFrames() ){
+		// track as many frames as fit into this update, then draw the last one
+		// (one frame only takes a few milliseconds, tracking one per update would wait on the frame rate)
+		unsigned long startTime = ofGetElapsedTimeMillis();
+		
+		// the frames only need to be uploaded when they're drawn (see drawPreview)
+		source.setUseTexture(false);
+		
+		while( appMode == APP_MODE_TRACKING && ofGetElapsedTimeMillis() - startTime < trackingBudget ){
 			
-			ofLogNotice("Finished tracking colors in file");
-			appMode = APP_MODE_IDLE;
-			bDataExtracted = true;
+			// move to the current frame
+			source.setFrame(currentFrame);
+			source.update();
+			
+			if( isRepeatedFrame(source.getPixelsRef()) ){
+				
+				// nothing has changed, use the last frame's shapes again
+				ShapeCollection repeated = frames.back();
+				repeated.bRepeated = true;
+				frames.push_back(repeated);
+				
+				numRepeatedFrames++;
+				
+			} else {
+				
+				// look for the matching pixels & convert shapes to vectors
+				convertToVectors(source.getPixelsRef());
+			}
+			 
+			// update the frame count
+			currentFrame++;
+			
+			// if we're at the end of the movie, stop
+			if( currentFrame == source.getTotalNumFrames() ) finishTracking();
 		}
 		
+		source.setUseTexture(true);
+		
 	} else if( appMode == APP_MODE_PLAYING ){
 		
 		// update the movie
 		source.update();
 		
+		// if we've caught up with the tracking, wait for it
+		if( !bDataExtracted ){
+			
+			bool bCaughtUp = source.getCurrentFrame() >= (int)frames.size() - 1;
+			
+			if( bCaughtUp != source.isPaused() ) source.setPaused(bCaughtUp);
+		}
+		
 	} else if( appMode == APP_MODE_SAVING ){
 		
 		// move to the current frame
@@ -88,6 +182,139 @@ void testApp::update(){
 			ofLogNotice("Finished saving shape data to disk");
 			appMode = APP_MODE_IDLE;
 		}
+		
+	} else if( appMode == APP_MODE_RENDERING ){
+		
+		// render as many frames as we can fit into this update
+		// but don't get too far ahead of the threads that are saving the images
+		unsigned long startTime = ofGetElapsedTimeMillis();
+		
+		while( currentFrame < frames.size() && imageWriter.getNumQueued() < 16 && ofGetElapsedTimeMillis() - startTime < 30 ){
+			
+			// splatter the frame's shapes into the canvas texture
+			updateCanvas(currentFrame);
+			
+			// copy the canvas and hand it off to be saved
+			ofPixels canvasPixels;
+			canvas.readToPixels(canvasPixels);
+			
+			char fileName[30];
+			sprintf(fileName, "render/render_%.5i.png", currentFrame);
+			imageWriter.addImage(canvasPixels, fileName);
+			
+			currentFrame++;
+		}
+		
+		// wait until every image has been saved
+		if( currentFrame >= frames.size() && imageWriter.isIdle() ){
+			
+			// the saving threads aren't needed until the next render
+			imageWriter.stop();
+			
+			ofLogNotice("Finished rendering animation to disk");
+			appMode = APP_MODE_IDLE;
+			ofSetFrameRate(30);
+		}
+		
+	} else if( appMode == APP_MODE_PRINTING ){
+		
+		// draw as many frames into the print canvas as we can fit into this update
+		unsigned long startTime = ofGetElapsedTimeMillis();
+		
+		while( currentFrame < frames.size() && ofGetElapsedTimeMillis() - startTime < 30 ){
+			
+			// get the splattered shapes & draw them into the tiles
+			vector< vector<ofPoint> > outlines;
+			frames[currentFrame].getSplatterOutlines(renderSeed + currentFrame, outlines);
+			printCanvas.drawShapes(outlines, frames[currentFrame].colors, printScale);
+			
+			currentFrame++;
+		}
+		
+		// once all of the frames are drawn, save the painting
+		if( currentFrame >= frames.size() ){
+			
+			bool bSaved = printCanvas.saveAsPPM("print/print.ppm");
+			printCanvas.close();
+			
+			if( bSaved ) ofLogNotice("Finished rendering print to disk");
+			appMode = APP_MODE_IDLE;
+		}
+		
+	} else if( appMode == APP_MODE_SWEEPING ){
+		
+		// move to the current frame (it's only uploaded when it's drawn)
+		source.setUseTexture(false);
+		source.setFrame(currentFrame);
+		source.update();
+		source.setUseTexture(true);
+		
+		if( isRepeatedFrame(source.getPixelsRef()) ){
+			
+			// nothing has changed, every setting gets its last frame's shapes again
+			for(int i=0; i<sweep.settings.size(); i++){
+				
+				sweep.addRepeatedFrame(i);
+			}
+			
+		} else {
+			
+			// the color distances only depend on the frame, so find them once
+			extractor.findColorDistances(source.getPixelsRef());
+			
+			// then extract & save the shapes for every setting
+			for(int i=0; i<sweep.settings.size(); i++){
+				
+				extractor.thresholdColorDistances(sweep.settings[i].threshold, sweep.settings[i].blurSize);
+				
+				ShapeCollection frameShapes;
+				extractor.extractShapes(source.getPixelsRef(), frameShapes, renderSeed + currentFrame);
+				sweep.addFrame(i, frameShapes);
+			}
+		}
+		
+		currentFrame++;
+		
+		if( currentFrame == source.getTotalNumFrames() ){
+			
+			sweep.end();
+			
+			ofLogNotice("Finished sweeping " + ofToString(sweep.settings.size()) + " settings");
+			appMode = APP_MODE_IDLE;
+			ofSetFrameRate(30);
+		}
+		
+	} else if( appMode == APP_MODE_FINDING_PALETTE ){
+		
+		// sample a frame, the frames are spread evenly across the movie
+		source.setFrame(currentFrame * source.getTotalNumFrames() / paletteFrames);
+		source.update();
+		
+		palette.addFrame(source.getPixelsRef(), extractor.region);
+		
+		currentFrame++;
+		
+		// once we have all of the samples, find the most common colors
+		if( currentFrame >= paletteFrames ){
+			
+			palette.findPalette();
+			
+			ofLogNotice("Found " + ofToString(palette.colors.size()) + " colors from " + ofToString(palette.getNumSamples()) + " pixels");
+			appMode = APP_MODE_IDLE;
+			ofSetFrameRate(30);
+		}
+		
+	} else if( appMode == APP_MODE_BATCH ){
+		
+		// the batch runs on its own threads, just wait for it
+		if( batch.isFinished() ){
+			
+			batch.stop();
+			batch.logFailedItems();
+			
+			ofLogNotice("Finished batch of " + ofToString((int)batch.items.size()) + " items");
+			appMode = APP_MODE_IDLE;
+		}
 	}
 }
 
@@ -103,30 +330,63 @@ void testApp::draw(){
 		ofSetColor(255, 255, 255);
 		source.draw(0, 0);
 		
+		// draw the colors we found, with their thresholds & how much of the movie they cover
+		if( palette.colors.size() > 0 ){
+			
+			ofSetColor(0, 255, 255);
+			ofDrawBitmapString("Press a number to track a color", ofGetWidth()/2+20, 20);
+			
+			for(int i=0; i<palette.colors.size(); i++){
+				
+				ofSetColor(palette.colors[i]);
+				ofRect(ofGetWidth()/2+20, 40 + i * 30, 20, 20);
+				
+				ofSetColor(0, 255, 255);
+				ofDrawBitmapString(ofToString(i+1)+": threshold "+ofToString(palette.thresholds[i])+", "+ofToString((int)(palette.shares[i] * 100))+"% of pixels", ofGetWidth()/2+50, 55 + i * 30);
+			}
+		}
+		
 		if( bDataExtracted ){
 			
 			// draw instructions
 			ofDrawBitmapString("Press RETURN to play animation", 20, 20);
 			ofDrawBitmapString("There 's' to save animation data ", 20, 40);
+			ofDrawBitmapString("Press 'r' to render animation to images", 20, 60);
+			ofDrawBitmapString("Press 'p' to render a print-size painting", 20, 80);
+			ofDrawBitmapString("Press 'w' to sweep thresholds (from sweep.xml)", 20, 100);
+			ofDrawBitmapString("Press 'k' to find the main colors in the movie", 20, 120);
+			ofDrawBitmapString("Press 'b' to track every movie in batch.xml", 20, 140);
 		}
 		
-	} else if ( appMode == APP_MODE_TRACKING ){
-	
+	} else if ( appMode == APP_MODE_TRACKING && segmentedExtraction.isRunning() ){
+		
 		// draw our source image
 		ofSetColor(255, 255, 255);
 		source.draw(0, 0);
 		
-		// draw the map
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Tracking "+ofToString(segmentedExtraction.getNumFramesDone())+"/"+ofToString(source.getTotalNumFrames())+" frames", ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("In "+ofToString(segmentedExtraction.segments.size())+" pieces at once", ofGetWidth()/2+20, 40);
+		ofDrawBitmapString(ofToString(segmentedExtraction.getNumRepeatedFrames())+" frames were repeats of the frame before", ofGetWidth()/2+20, 60);
+		ofDrawBitmapString("Press 'k' to find the main colors in the movie instead", ofGetWidth()/2+20, 80);
+		
+		if( frames.size() > 0 ) ofDrawBitmapString("Press RETURN to play what's been tracked so far", ofGetWidth()/2+20, 100);
+		
+	} else if ( appMode == APP_MODE_TRACKING ){
+	
+		// draw the frame we're on & its map
 		// the white pixels indicate matching colors
 		ofSetColor(255, 255, 255);
-		colorMap.draw(ofGetWidth()/2, 0);
+		drawPreview();
 		
-		// draw the blobs found in the open cv search
-		contourFinder.draw(ofGetWidth()/2, 0);
+		// draw the blobs found in the open cv search (where the region is)
+		extractor.contourFinder.draw(ofGetWidth()/2 + extractor.region.x, extractor.region.y);
 		
 		ofSetColor(0, 255, 255);
 		ofDrawBitmapString("Tracking frame "+ofToString(currentFrame)+"/"+ofToString(source.getTotalNumFrames()), ofGetWidth()/2+20, 20);
-		ofDrawBitmapString("There are "+ofToString(contourFinder.nBlobs)+" shapes", ofGetWidth()/2+20, 40);
+		ofDrawBitmapString("There are "+ofToString(extractor.contourFinder.nBlobs)+" shapes", ofGetWidth()/2+20, 40);
+		ofDrawBitmapString(ofToString(numRepeatedFrames)+" frames were repeats of the frame before", ofGetWidth()/2+20, 60);
+		ofDrawBitmapString("Press 'k' to find the main colors in the movie instead", ofGetWidth()/2+20, 80);
 		
 	} else if(  appMode == APP_MODE_PLAYING) {
 	
@@ -138,28 +398,47 @@ void testApp::draw(){
 		
 			// only when there's a new frame 
 			// so we don't draw shapes multiple times
-			int currentFrame = source.getCurrentFrame();
-
-			// draw splatter into texture
-			canvas.begin();
-			
-			if( currentFrame < frames.size()) {
-			
-				frames[currentFrame].drawSplatter();
-			}
-			
-			canvas.end();
-			
+			// (if we've skipped around in the movie the canvas catches up from a keyframe)
+			updateCanvas(source.getCurrentFrame());
 		}
 		
 		// draw that texture
 		ofSetColor(255, 255, 255);
 		canvas.draw(ofGetWidth()/2, 0);
 		
+		ofSetColor(0, 255, 255);
+		string keyframeInfo = ofToString(keyframes.getNumKeyframes())+" keyframes, every "+ofToString(keyframes.getInterval())+" frames";
+		if( bBuildingKeyframes ) keyframeInfo += " (taking them, "+ofToString(keyframeFrame + 1)+"/"+ofToString(frames.size())+")";
+		ofDrawBitmapString(keyframeInfo, ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("LEFT/RIGHT or drag across the movie to seek", ofGetWidth()/2+20, 40);
+		
+		// how detailed the shapes drawn the last time the canvas was updated were (level 0 is the full outline)
+		string levelInfo = "Shapes drawn at each level of detail:";
+		
+		for(int i=0; i<levelCounts.size(); i++){
+			
+			levelInfo += " " + ofToString(levelCounts[i]);
+		}
+		
+		ofDrawBitmapString(levelInfo, ofGetWidth()/2+20, 60);
+		
+		// still tracking the rest of the movie
+		if( segmentedExtraction.isRunning() ){
+			
+			ofDrawBitmapString("Tracked "+ofToString(frames.size())+"/"+ofToString(source.getTotalNumFrames())+" frames so far", ofGetWidth()/2+20, 80);
+			
+			if( source.isPaused() ) ofDrawBitmapString("Waiting for the tracking to catch up", ofGetWidth()/2+20, 100);
+		}
+		
 		if( source.getPosition() == 1.0 ){
 			
 			ofDrawBitmapString("Press RETURN to play animation", 20, 20);
 			ofDrawBitmapString("There 's' to save animation data ", 20, 40);
+			ofDrawBitmapString("Press 'r' to render animation to images", 20, 60);
+			ofDrawBitmapString("Press 'p' to render a print-size painting", 20, 80);
+			ofDrawBitmapString("Press 'w' to sweep thresholds (from sweep.xml)", 20, 100);
+			ofDrawBitmapString("Press 'k' to find the main colors in the movie", 20, 120);
+			ofDrawBitmapString("Press 'b' to track every movie in batch.xml", 20, 140);
 		}
 		
 	} else if(appMode == APP_MODE_SAVING) {
@@ -180,6 +459,54 @@ void testApp::draw(){
 		
 		ofSetColor(0, 255, 255);
 		ofDrawBitmapString("Saving frame "+ofToString(currentFrame)+"/"+ofToString(source.getTotalNumFrames()), ofGetWidth()/2+20, 20);
+		
+	} else if(appMode == APP_MODE_RENDERING) {
+		
+		// show the canvas as it's being rendered
+		ofSetColor(255, 255, 255);
+		canvas.draw(ofGetWidth()/2, 0);
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Rendering frame "+ofToString(currentFrame)+"/"+ofToString(frames.size()), ofGetWidth()/2+20, 20);
+		
+	} else if(appMode == APP_MODE_PRINTING) {
+		
+		ofSetColor(255, 255, 255);
+		source.draw(0, 0);
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Printing frame "+ofToString(currentFrame)+"/"+ofToString(frames.size()), ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("Print size "+ofToString(printCanvas.width)+" x "+ofToString(printCanvas.height), ofGetWidth()/2+20, 40);
+		
+	} else if(appMode == APP_MODE_SWEEPING) {
+		
+		// show the source & the map for the last setting
+		ofSetColor(255, 255, 255);
+		drawPreview();
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Sweeping frame "+ofToString(currentFrame)+"/"+ofToString(source.getTotalNumFrames()), ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("Trying "+ofToString(sweep.settings.size())+" settings", ofGetWidth()/2+20, 40);
+		
+	} else if(appMode == APP_MODE_FINDING_PALETTE) {
+		
+		ofSetColor(255, 255, 255);
+		source.draw(0, 0);
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Sampling colors from frame "+ofToString(currentFrame)+"/"+ofToString(paletteFrames), ofGetWidth()/2+20, 20);
+		
+	} else if(appMode == APP_MODE_BATCH) {
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Tracking chunk "+ofToString(batch.getNumChunksDone())+"/"+ofToString(batch.getNumChunks())+" of "+ofToString((int)batch.items.size())+" movies", 20, 20);
+		ofDrawBitmapString("On "+ofToString((int)batch.workers.size())+" threads", 20, 40);
+		ofDrawBitmapString("Press 'b' to stop (finished chunks are kept for next time)", 20, 60);
+		
+		if( batch.getNumChunksFailed() > 0 ){
+			
+			ofDrawBitmapString(ofToString(batch.getNumChunksFailed())+" chunks failed", 20, 80);
+		}
 	}
 }
 
@@ -214,172 +541,400 @@ ofColor testApp::getColorAtPos(ofPixels & pixels, int x, int y){
 
 //--------------------------------------------------------------
 
-// get all of similar colors in an image
+// find the shapes in a frame & convert them to vectors
 
-void testApp::searchForColorInPixels(ofColor & color, ofPixels & pixels, int thresh){
+void testApp::convertToVectors(ofPixels & pixels){
 	
-	// get a pointer to the pixel arrays for the search image and the map image
-	unsigned char * pix = pixels.getPixels();
-	unsigned char * mapPix = colorMap.getPixels();
+	// a container for all of the shapes from the current frame
+	// (the colors of the shapes are sampled randomly, seeding with the frame means a sweep gets the same shapes)
+	ShapeCollection frameShapes;
+	extractor.extract(pixels, frameShapes, renderSeed + currentFrame);
 	
-	// figure out the size of the images and the # of channels
-	int numPix = pixels.getWidth() * pixels.getHeight();
-	int channels = pixels.getNumChannels();
+	// link the shapes to the ones in the last frame
+	tracker.track(frameShapes);
 	
-	// calculate the minimum distance to be considered a matching color
-	int minDist = thresh * thresh * thresh;
+	// add the curren frame to the queue
+	frames.push_back(frameShapes);
+}
+
+//--------------------------------------------------------------
+
+// is a frame the same as the last frame we found shapes in? (held titles, freeze frames, telecine)
+// repeats aren't compared with each other, otherwise a slow fade could keep matching forever
+
+bool testApp::isRepeatedFrame(ofPixels & pixels){
 	
-	for(int i=0; i<numPix; i++){
+	frameFingerprint.set(pixels);
 	
-		int posInMem = i * channels;
-		int dstInMem = i;
+	if( frameFingerprint.matches(lastFingerprint) ) return true;
 	
-		// get the RGB values
-		unsigned char r = pix[posInMem]; 
-		unsigned char g = pix[posInMem+1]; 
-		unsigned char b = pix[posInMem+2]; 
-		
-		// get the difference
-		int diffR = color.r - r;
-		int diffG = color.g - g; 
-		int diffB = color.b - b; 
+	lastFingerprint.swap(frameFingerprint);
+	
+	return false;
+}
+
+//--------------------------------------------------------------
+
+// show the latest movie frame & map that were tracked, side by side
+// they're uploaded here, once per draw, rather than every time a frame is tracked
+
+void testApp::drawPreview(){
+	
+	previewFrame.loadData(source.getPixels(), source.getWidth(), source.getHeight(), GL_RGB);
+	previewFrame.draw(0, 0);
+	
+	previewMap.loadData(extractor.colorMap.getPixels(), extractor.colorMap.getWidth(), extractor.colorMap.getHeight(), GL_LUMINANCE);
+	previewMap.draw(ofGetWidth()/2 + extractor.region.x, extractor.region.y);
+}
+
+//--------------------------------------------------------------
+
+// fill the canvas with the paper color
+
+void testApp::clearCanvas(){
+	
+	canvas.begin();
+	ofClear(238, 234, 213);
+	canvas.end();
+	
+	canvasFrame = -1;
+}
+
+//--------------------------------------------------------------
+
+// bring the canvas up to date with a frame of the animation
+// the canvas accumulates shapes, so it depends on every frame before this one
+// when we jump around, start from the closest keyframe & replay the frames after it
+// (until buildKeyframes has been through every frame, jumping past the last keyframe
+// still has to replay everything since it)
+
+void testApp::updateCanvas(int frame){
+	
+	frame = MIN(frame, (int)frames.size() - 1);
+	
+	if( frame == canvasFrame ) return;
+	
+	levelCounts.assign(ShapeCollection::numLevels, 0);
+	
+	// going backwards, or far enough ahead that a keyframe is closer
+	if( frame < canvasFrame || frame - canvasFrame > keyframes.getInterval() ){
 		
-		// get the distance
-		float dist = ( diffR * diffR ) + ( diffG * diffG ) + ( diffB * diffB );
+		int keyframe = keyframes.getKeyframeBefore(frame);
 		
-		// set to black or white depending on the difference 
-		if( dist < minDist ){
+		if( keyframe >= 0 && (keyframe > canvasFrame || frame < canvasFrame) ){
 			
-			mapPix[dstInMem] = 255;
+			keyframes.restoreKeyframe(keyframe, canvas);
+			canvasFrame = keyframe;
 			
-		} else {
+		} else if( frame < canvasFrame ){
 			
-			mapPix[dstInMem] = 0;
+			// no keyframe to go back to, start from scratch
+			clearCanvas();
 		}
 	}
 	
-	// update the pixels
-	colorMap.setFromPixels(mapPix, colorMap.getWidth(), colorMap.getHeight());
-	colorMap.updateTexture();
+	// replay the frames in between, taking snapshots along the way
+	while( canvasFrame < frame ){
+		
+		canvasFrame++;
+		
+		canvas.begin();
+		frames[canvasFrame].drawSplatter(renderSeed + canvasFrame, 1.0, &levelCounts);
+		canvas.end();
+		
+		if( keyframes.isKeyframe(canvasFrame) ){
+			
+			keyframes.addKeyframe(canvasFrame, canvas);
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+// once the frames are all tracked (or loaded) go through them once, in order, drawing them into
+// a canvas of their own & taking every keyframe, so seeking anywhere only replays from the closest one
+// the frames are read from the cache by a reader of their own so the frames being played aren't
+// pushed out of memory (if there's no cache they're all in memory anyway)
+
+void testApp::startKeyframes(){
+	
+	keyframeReader.open(extractionCache.getPath());
 	
-	// do a little blurring & thresholding to smooth out the edges
-	colorMap.blur(5);
-	colorMap.threshold(128);
+	keyframeCanvas.begin();
+	ofClear(238, 234, 213);
+	keyframeCanvas.end();
+	
+	keyframeFrame = -1;
+	bBuildingKeyframes = true;
 }
 
 //--------------------------------------------------------------
 
-// use opencv's contour finder to get the outlines from a greyscale image
+void testApp::buildKeyframes(){
+	
+	unsigned long startTime = ofGetElapsedTimeMillis();
+	
+	while( keyframeFrame < (int)frames.size() - 1 && ofGetElapsedTimeMillis() - startTime < 10 ){
+		
+		keyframeFrame++;
+		
+		keyframeCanvas.begin();
+		
+		if( keyframeReader.isOpen() ){
+			
+			ShapeCollection frame;
+			keyframeReader.getFrame(keyframeFrame, frame);
+			frame.drawSplatter(renderSeed + keyframeFrame);
+			
+		} else {
+			
+			frames[keyframeFrame].drawSplatter(renderSeed + keyframeFrame);
+		}
+		
+		keyframeCanvas.end();
+		
+		if( keyframes.isKeyframe(keyframeFrame) ){
+			
+			keyframes.addKeyframe(keyframeFrame, keyframeCanvas);
+		}
+	}
+	
+	if( keyframeFrame == (int)frames.size() - 1 ){
+		
+		keyframeReader.close();
+		bBuildingKeyframes = false;
+	}
+}
 
-void testApp::convertToVectors(ofxCvGrayscaleImage & map){
+//--------------------------------------------------------------
 
-	contourFinder.findContours(map, 5, ofGetWidth() * ofGetHeight(), 20000, true, false);
+void testApp::startTracking(){
 	
-	// a container for all of the shapes from the current frame
-	ShapeCollection frameShapes;
+	// stop any tracking that's still going
+	segmentedExtraction.clear();
+	
+	appMode = APP_MODE_TRACKING;
+	currentFrame = 0;
+	frames.clear();
+	frames.setMemoryBudget(frameMemoryBudget);
+	tracker.reset();
+	lastFingerprint.clear();
+	numRepeatedFrames = 0;
+	bDataExtracted = false;
 	
-	// get the shape count
-	int numShapes = contourFinder.nBlobs;
+	// keep canvas snapshots for seeking, in up to 64 MB of memory
+	// (set up now so the frames can be played while they're still being tracked)
+	keyframes.setup(source.getTotalNumFrames(), 64 * 1024 * 1024);
+	keyframeReader.close();
+	bBuildingKeyframes = false;
 	
-	for(int i=0; i<numShapes; i++){
+	// if this movie has already been tracked with the same settings, skip straight to playback
+	extractionCache = movieCache;
+	extractor.addToKey(extractionCache, extractor.threshold, extractor.blurSize, renderSeed);
+	
+	if( extractionCache.load(frames) ){
+		
+		ofLogNotice("Loaded " + ofToString(frames.size()) + " frames of shapes from " + extractionCache.getPath());
+		bDataExtracted = true;
+		startKeyframes();
+		
+		startPlayback();
 		
-		// copy all of the shape data over to a new cvBlob
-		ofxCvBlob newBlob;
-		newBlob.nPts = contourFinder.blobs[i].nPts;
-		newBlob.pts.insert(newBlob.pts.begin(), contourFinder.blobs[i].pts.begin(), contourFinder.blobs[i].pts.end());
-		newBlob.boundingRect = contourFinder.blobs[i].boundingRect;
-		frameShapes.addShape(newBlob);
+	} else {
 		
-		// get the color
-		ofColor shapeColor = getColorOfShape(contourFinder.blobs[i]);
-		frameShapes.addColor(shapeColor);
+		// otherwise track it, writing the shapes into the cache as they're found
+		// (if the cache can't be written, every frame is kept in memory)
+		if( !extractionCache.beginSave(frames) ) ofLog(OF_LOG_WARNING, "Failed to create " + extractionCache.getPath() + ".tmp");
+		
+		// split the movie into pieces & track them all at once
+		// (if the movie can't be opened again, track it here a frame at a time)
+		// the pieces wait for their turn in part files next to the cache entry
+		if( numSegments > 1 ) segmentedExtraction.start(moviePath, source.getTotalNumFrames(), numSegments, extractor, renderSeed, extractionCache.folder + "/" + extractionCache.getKey());
 	}
+}
+
+//--------------------------------------------------------------
+
+void testApp::finishTracking(){
 	
-	// add the curren frame to the queue
-	frames.push_back(frameShapes);
+	ofLogNotice("Finished tracking colors in file");
+	bDataExtracted = true;
+	
+	// if we were playing the frames as they came in, carry on
+	if( appMode == APP_MODE_TRACKING ) appMode = APP_MODE_IDLE;
+	else if( appMode == APP_MODE_PLAYING ) source.setPaused(false);
+	
+	// remember the shapes so the next run can skip tracking
+	// (they've been written into the cache as they were tracked, this finishes the entry)
+	if( !extractionCache.endSave(frames) ) ofLog(OF_LOG_WARNING, "Failed to save shapes to " + extractionCache.getPath());
+	
+	// now every frame is known, take all of the keyframes
+	startKeyframes();
 }
 
 //--------------------------------------------------------------
 
-// this is one of many ways to grab the color from a blob
-// it's actually a very fast and not-so accurate way to do so 
-// we're grabbing 5 random colors and averaging them
-// but we need make sure that the randomly selected colors are from those 
-// pixels that has changed since the last frame (which are the white pixels 
-// saved in the cvImage changedPixelsMap)
+void testApp::startPlayback(){
+	
+	// start play mode (at the first frame)
+	appMode = APP_MODE_PLAYING;
+	currentFrame = 0;
+	
+	// stream the frames if they're all in the cache
+	frames.setMemoryBudget( bDataExtracted ? playbackMemoryBudget : frameMemoryBudget );
+	
+	// clear the canvas, the keyframes we've stored stay around for seeking
+	clearCanvas();
+	
+	// start the movie
+	source.setPosition(0.0);
+	source.play();
+	source.setLoopState(OF_LOOP_NONE);
+}
 
-ofColor testApp::getColorOfShape(ofxCvBlob & shape){
+//--------------------------------------------------------------
+
+// jump to a frame in the movie & the animation
+
+void testApp::seekToFrame(int frame){
 	
-	ofColor results;
-	ofRectangle searchRect = shape.boundingRect;
+	frame = ofClamp(frame, 0, frames.size() - 1);
 	
-	unsigned char * mapPix = colorMap.getPixels();
-	unsigned char * pix = source.getPixels();
+	source.setFrame(frame);
+	updateCanvas(frame);
+}
+
+//--------------------------------------------------------------
+
+void testApp::keyPressed(int key){
 	
-	int sumR = 0;
-	int sumG = 0;
-	int sumB = 0;
+	// while the batch is running the only thing to do is stop it
+	if( appMode == APP_MODE_BATCH && key != 'b' ) return;
 	
-	int pixFound = 0;
+	// saving, rendering, printing, sweeping & finding a palette have to finish before something else is started
+	bool bInterruptible = ( appMode == APP_MODE_IDLE || appMode == APP_MODE_TRACKING || appMode == APP_MODE_PLAYING );
 	
-	while( pixFound < 5 ){
+	if( key == 'k' && bInterruptible ){
+		
+		// look for the most common colors in the movie (this stops tracking)
+		segmentedExtraction.clear();
+		appMode = APP_MODE_FINDING_PALETTE;
+		currentFrame = 0;
+		ofSetFrameRate(0);
+		
+		palette.clear();
+		return;
+	}
 	
-		// randomly look in the blob area for a white color
-		int randX = searchRect.x + ofRandom(searchRect.width);
-		int randY = searchRect.y + ofRandom(searchRect.height);
-		int memPos = randY * colorMap.getWidth() + randX;
+	if( key >= '1' && key < '1' + (int)palette.colors.size() && bInterruptible ){
 		
-		// if the map pixel is white
-		if( mapPix[memPos] == 255 ){
+		// track one of the colors we found
+		extractor.searchColor = palette.colors[key - '1'];
+		extractor.threshold = palette.thresholds[key - '1'];
 		
-			// mult by 3 (because it's a color source)
-			memPos = memPos * 3;
-			
-			// get the RGB values
-			sumR += pix[memPos];
-			sumG += pix[memPos+1];
-			sumB += pix[memPos+2];
+		startTracking();
+		return;
+	}
+	
+	if( key == 'b' && appMode == APP_MODE_BATCH ){
+		
+		// stop the batch, it carries on from the last finished chunks next time
+		batch.stop();
+		appMode = APP_MODE_IDLE;
+		return;
+	}
+	
+	if( key == 'b' && bInterruptible ){
+		
+		// start batch mode
+		// track every movie & still in batch.xml on every core, into the extraction cache
+		// (this stops tracking the movie that's open)
+		segmentedExtraction.clear();
+		
+		if( batch.start("batch.xml", extractor, renderSeed) ){
 			
-			pixFound++;
+			source.stop();
+			appMode = APP_MODE_BATCH;
 		}
+		
+		return;
 	}
 	
-	// update the color with the average values
-	results.r = sumR/pixFound;
-	results.g = sumG/pixFound;
-	results.b = sumB/pixFound;
-	
-	return results;
-}
- 
-//--------------------------------------------------------------
-
-void testApp::keyPressed(int key){
+	// the frames that have been tracked can be played while the rest are still being tracked
+	if( key == OF_KEY_RETURN && !bDataExtracted && segmentedExtraction.isRunning() && frames.size() > 0 ){
+		
+		startPlayback();
+		return;
+	}
 	
 	// don't do anything unless we've extracted all of our movement data
 	if( bDataExtracted ){
 
 		if( key == OF_KEY_RETURN ){
 		
-			// start playback
-			currentFrame = 0;
-			appMode = APP_MODE_PLAYING;
-			
-			// clear the canvas texture by filling it with a solid color
-			canvas.begin();
-			ofClear(238, 234, 213);
-			canvas.end();
-			
-			// prepare the movie
-			source.setPosition(0.0);
-			source.play();
-			source.setLoopState(OF_LOOP_NONE);
+			startPlayback();
 		
 		} else if( key == 's' ){
 			
 			// start save mode
 			currentFrame = 0;
 			appMode = APP_MODE_SAVING;
+		
+		} else if( appMode == APP_MODE_PLAYING && (key == OF_KEY_LEFT || key == OF_KEY_RIGHT) ){
+			
+			// skip back or ahead one second
+			int offset = ( key == OF_KEY_LEFT ) ? -30 : 30;
+			seekToFrame(source.getCurrentFrame() + offset);
+		
+		} else if( key == 'r' ){
+			
+			// start render mode
+			// draw every frame into the canvas & save it as an image, as fast as we can
+			appMode = APP_MODE_RENDERING;
+			currentFrame = 0;
+			ofSetFrameRate(0);
+			
+			clearCanvas();
+			
+			ofDirectory::createDirectory("render");
+			imageWriter.start();
+		
+		} else if( key == 'p' ){
+			
+			// start print mode
+			// draw the whole animation into one very large canvas that's stored on disk
+			ofDirectory::createDirectory("print");
+			
+			if( printCanvas.setup(source.getWidth() * printScale, source.getHeight() * printScale, "print/canvas.tiles", ofColor(238, 234, 213)) ){
+				
+				appMode = APP_MODE_PRINTING;
+				currentFrame = 0;
+				
+			} else {
+				
+				ofLog(OF_LOG_ERROR, "Failed to create the print canvas");
+			}
+		
+		} else if( key == 'w' ){
+			
+			// start sweep mode
+			// track the movie again with every setting in sweep.xml, decoding each frame once
+			sweep.setup("sweep.xml", extractor.threshold, extractor.blurSize);
+			
+			for(int i=0; i<sweep.settings.size(); i++){
+				
+				sweep.settings[i].cache = movieCache;
+				extractor.addToKey(sweep.settings[i].cache, sweep.settings[i].threshold, sweep.settings[i].blurSize, renderSeed);
+			}
+			
+			if( sweep.begin() ){
+				
+				appMode = APP_MODE_SWEEPING;
+				currentFrame = 0;
+				lastFingerprint.clear();
+				ofSetFrameRate(0);
+			}
+		
 		}
 	}
 }
@@ -400,6 +955,11 @@ void testApp::mouseMoved(int x, int y){
 
 void testApp::mouseDragged(int x, int y, int button){
 
+	// scrub thru the animation by dragging across the movie
+	if( appMode == APP_MODE_PLAYING && x < ofGetWidth()/2 ){
+		
+		seekToFrame( (float)x / (ofGetWidth()/2) * frames.size() );
+	}
 }
 
 //--------------------------------------------------------------
@@ -0,0 +1,164 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "NumCores.h"
+
+// saves numbered images on a pool of background threads
+// so the app can keep drawing while the images are encoded
+
+class ImageSequenceWriter {
+
+public:
+
+	//--------------------------------------------------------------
+
+	// one worker in the pool
+	// it takes the oldest image from the queue and saves it to disk
+
+	class SaverThread : public ofThread {
+
+	public:
+
+		ImageSequenceWriter * writer;
+
+		void threadedFunction(){
+
+			while( isThreadRunning() ){
+
+				ofPixels pixels;
+				string filePath;
+
+				if( writer->getNextImage(pixels, filePath) ){
+
+					ofSaveImage(pixels, filePath);
+					writer->finishedImage();
+
+				} else {
+
+					// nothing to do, wait a moment
+					ofSleepMillis(1);
+				}
+			}
+		}
+	};
+
+	//--------------------------------------------------------------
+
+	ImageSequenceWriter(){
+
+		numPending = 0;
+	}
+
+	~ImageSequenceWriter(){
+
+		stop();
+	}
+
+	//--------------------------------------------------------------
+
+	// start the worker threads
+	// by default use one per processor core
+
+	void start(int numThreads = 0){
+
+		if( threads.size() > 0 ) return;
+
+		if( numThreads <= 0 ) numThreads = getNumCores();
+
+		for(int i=0; i<numThreads; i++){
+
+			SaverThread * thread = new SaverThread();
+			thread->writer = this;
+			thread->startThread(false, false);
+			threads.push_back(thread);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// wait for the queue to empty, then shut down the worker threads
+
+	void stop(){
+
+		while( !isIdle() && threads.size() > 0 ){
+
+			ofSleepMillis(1);
+		}
+
+		for(int i=0; i<threads.size(); i++){
+
+			threads[i]->waitForThread(true);
+			delete threads[i];
+		}
+
+		threads.clear();
+	}
+
+	//--------------------------------------------------------------
+
+	// queue a copy of the pixels to be saved
+
+	void addImage(ofPixels & pixels, string filePath){
+
+		ofScopedLock lock(mutex);
+
+		queuedPixels.push_back(pixels);
+		queuedPaths.push_back(filePath);
+		numPending++;
+	}
+
+	//--------------------------------------------------------------
+
+	// the number of images waiting in the queue (not counting the ones being saved)
+
+	int getNumQueued(){
+
+		ofScopedLock lock(mutex);
+
+		return queuedPixels.size();
+	}
+
+	//--------------------------------------------------------------
+
+	// true when every queued image has been written
+
+	bool isIdle(){
+
+		ofScopedLock lock(mutex);
+
+		return numPending == 0;
+	}
+
+	//--------------------------------------------------------------
+
+	// called by the worker threads
+
+	bool getNextImage(ofPixels & pixels, string & filePath){
+
+		ofScopedLock lock(mutex);
+
+		if( queuedPixels.size() == 0 ) return false;
+
+		pixels = queuedPixels.front();
+		filePath = queuedPaths.front();
+
+		queuedPixels.pop_front();
+		queuedPaths.pop_front();
+
+		return true;
+	}
+
+	void finishedImage(){
+
+		ofScopedLock lock(mutex);
+
+		numPending--;
+	}
+
+	vector<SaverThread*> threads;
+	deque<ofPixels> queuedPixels;
+	deque<string> queuedPaths;
+	int numPending;
+	ofMutex mutex;
+};
@@ -0,0 +1,13 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "Poco/Environment.h"
+
+// how many threads to run for work that can keep every core busy
+// (the image writer's pool, the tracking segments & the batch workers)
+
+inline int getNumCores(){
+
+	return MAX(1, (int)Poco::Environment::processorCount());
+}
@@ -0,0 +1,267 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ShapeCollection.h"
+#include "FrameRegion.h"
+
+// finds the shapes of the motion between two frames
+// everything it works with is its own (even its random numbers), so each thread can have one
+// the colors of the shapes are sampled at random, seeding with the frame number means the same
+// frame always gets the same shapes, whichever thread it's found on
+// only the pixels in the region are looked at (see FrameRegion), the images are only as big as the region
+
+class ShapeExtractor {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ShapeExtractor(){
+
+		threshold = 35;
+		blurSize = 5;
+		minShapeArea = 5;
+		maxShapeArea = 0;
+		maxShapes = 20000;
+		randomState = 1;
+	}
+
+	//--------------------------------------------------------------
+
+	// off the main thread the images can't have textures
+	// (& the app doesn't give them any either, it only uploads the map when it's drawn)
+
+	void setup(int width, int height, bool bUseTexture = true){
+
+		region.setup(width, height);
+
+		currentFrameCvRGB.setUseTexture(bUseTexture);
+		currentFrameCv.setUseTexture(bUseTexture);
+		previouFrameCv.setUseTexture(bUseTexture);
+		frameDifference.setUseTexture(bUseTexture);
+		changedPixelsMap.setUseTexture(bUseTexture);
+
+		currentFrameCvRGB.allocate(region.width, region.height);
+		currentFrameCv.allocate(region.width, region.height);
+		previouFrameCv.allocate(region.width, region.height);
+		frameDifference.allocate(region.width, region.height);
+		changedPixelsMap.allocate(region.width, region.height);
+
+		// shapes can't be more than 1/25 of the frame
+		if( maxShapeArea == 0 ) maxShapeArea = width * 2 * height / 25;
+	}
+
+	//--------------------------------------------------------------
+
+	// copy the settings that change the shapes from another extractor
+
+	void copySettings(ShapeExtractor & other){
+
+		threshold = other.threshold;
+		blurSize = other.blurSize;
+		minShapeArea = other.minShapeArea;
+		maxShapeArea = other.maxShapeArea;
+		maxShapes = other.maxShapes;
+		region = other.region;
+	}
+
+	//--------------------------------------------------------------
+
+	// add the settings that change the shapes to a cache key (the app & the batch share it, so they find each other's shapes)
+	// the threshold & blur are passed in, so a sweep can key its settings the same way
+
+	template <class Key>
+	void addToKey(Key & key, int thresh, int blur, int seed){
+
+		key.addValue(thresh);
+		key.addValue(blur);
+		key.addValue(minShapeArea);
+		key.addValue(maxShapeArea);
+		key.addValue(maxShapes);
+		key.addValue(seed);
+		region.addToKey(key);
+	}
+
+	//--------------------------------------------------------------
+
+	// move on to the next frame, the current frame becomes the previous frame
+
+	void setFrame(ofPixels & pixels){
+
+		previouFrameCv = currentFrameCv;
+
+		// convert the region to a grayscale cvImage
+		if( region.isWholeFrame() ){
+
+			currentFrameCvRGB.setFromPixels(pixels.getPixels(), pixels.getWidth(), pixels.getHeight());
+
+		} else {
+
+			region.crop(pixels, croppedFrame);
+			currentFrameCvRGB.setFromPixels(croppedFrame.getPixels(), region.width, region.height);
+		}
+
+		currentFrameCv = currentFrameCvRGB;
+	}
+
+	//--------------------------------------------------------------
+
+	// find the shapes of the motion between the previous & current frame with the current settings
+
+	void extract(ofPixels & pixels, ShapeCollection & frameShapes, int seed){
+
+		findFrameDifference();
+		thresholdFrameDifference(threshold, blurSize);
+		extractShapes(pixels, frameShapes, seed);
+	}
+
+	//--------------------------------------------------------------
+
+	// find how much every pixel changed between the frames
+
+	void findFrameDifference(){
+
+		frameDifference = currentFrameCv;
+
+		frameDifference.absDiff(previouFrameCv);
+	}
+
+	//--------------------------------------------------------------
+
+	// turn the difference into a map of the pixels that changed
+
+	void thresholdFrameDifference(int thresh, int blur){
+
+		changedPixelsMap = frameDifference;
+
+		changedPixelsMap.threshold(thresh, false);
+
+		changedPixelsMap.blur(blur);
+
+		changedPixelsMap.threshold(128);
+
+		// the blur can spread into the areas that are left out
+		region.applyMask(changedPixelsMap);
+	}
+
+	//--------------------------------------------------------------
+
+	// use opencv's contour finder to get the outlines from the map
+
+	void extractShapes(ofPixels & pixels, ShapeCollection & frameShapes, int seed){
+
+		seedRandom(seed);
+
+		contourFinder.findContours(changedPixelsMap, minShapeArea, maxShapeArea, maxShapes, true, false);
+
+		int numShapes = contourFinder.nBlobs;
+
+		for(int i=0; i<numShapes; i++){
+
+			// create a new blob
+			// copy over the blob data from the source blob
+			ofxCvBlob newBlob;
+			newBlob.nPts = contourFinder.blobs[i].nPts;
+			newBlob.pts.insert(newBlob.pts.begin(), contourFinder.blobs[i].pts.begin(), contourFinder.blobs[i].pts.end());
+			newBlob.boundingRect = contourFinder.blobs[i].boundingRect;
+			region.moveToFrame(newBlob);
+			frameShapes.addShape(newBlob);
+
+			ofColor shapeColor = getColorOfShape(contourFinder.blobs[i], pixels);
+			frameShapes.addColor(shapeColor);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// this is one of many ways to grab the color from a blob
+	// it's actually a very fast and not-so accurate way to do so
+	// we're grabbing 5 random colors and averaging them
+	// but we need make sure that the randomly selected colors are from those
+	// pixels that has changed since the last frame (which are the white pixels
+	// saved in the cvImage changedPixelsMap)
+	// the shape is where it was found in the map, not in the frame
+
+	ofColor getColorOfShape(ofxCvBlob & shape, ofPixels & pixels){
+
+		ofColor results;
+		ofRectangle searchRect = shape.boundingRect;
+
+		unsigned char * mapPix = changedPixelsMap.getPixels();
+		unsigned char * pix = pixels.getPixels();
+
+		int sumR = 0;
+		int sumG = 0;
+		int sumB = 0;
+
+		int pixFound = 0;
+
+		while( pixFound < 5 ){
+
+			// randomly look in the blob area for a white color
+			int randX = searchRect.x + random(searchRect.width);
+			int randY = searchRect.y + random(searchRect.height);
+			int memPos = randY * region.width + randX;
+
+			// if the pixel is white
+			if( mapPix[memPos] == 255 ){
+
+				// find the pixel in the frame & mult by 3 (because it's a color source)
+				memPos = ((randY + region.y) * pixels.getWidth() + randX + region.x) * 3;
+
+				// get the RGB values
+				sumR += pix[memPos];
+				sumG += pix[memPos+1];
+				sumB += pix[memPos+2];
+
+				pixFound++;
+			}
+		}
+
+		// update the color with the average values
+		results.r = sumR/pixFound;
+		results.g = sumG/pixFound;
+		results.b = sumB/pixFound;
+
+		return results;
+	}
+
+	//--------------------------------------------------------------
+
+	// ofRandom shares one generator between every thread, so use our own (xorshift)
+
+	void seedRandom(int seed){
+
+		randomState = (unsigned int)seed * 2654435761u;
+
+		if( randomState == 0 ) randomState = 1;
+	}
+
+	float random(float max){
+
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+
+		return max * (randomState / 4294967296.0f);
+	}
+
+	// the settings that change the shapes
+	int threshold;
+	int blurSize;
+	int minShapeArea;
+	int maxShapeArea;
+	int maxShapes;
+	FrameRegion region;
+
+	ofPixels croppedFrame;
+	ofxCvColorImage currentFrameCvRGB;
+	ofxCvGrayscaleImage currentFrameCv;
+	ofxCvGrayscaleImage previouFrameCv;
+	ofxCvGrayscaleImage frameDifference;
+	ofxCvGrayscaleImage changedPixelsMap;
+	ofxCvContourFinder contourFinder;
+	unsigned int randomState;
+};
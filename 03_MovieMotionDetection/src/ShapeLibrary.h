@@ -0,0 +1,548 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeCollection.h"
+#include "ShapeSequenceFile.h"
+
+#include <queue>
+
+// a library of the shapes in many shape sequences, for finding shapes that look like a shape
+//
+// every shape gets a short descriptor, the parts are scaled so a big difference is a few units:
+//   hu:          the 7 hu moments of the outline (they don't change with position, size or rotation),
+//                as signed logs, so the tiny higher moments still count
+//   aspect:      log2 of the width / height of the bounding rect
+//   complexity:  log2 of how much longer the outline is than a circle's with the same area
+//   area:        log10 of the area inside the outline
+//   color:       rgb / 64
+// the descriptors are kept in a kd-tree, so finding the nearest shapes only looks at a few of them
+// the distance is weighted (see setWeights), so a search can ignore the color or the size
+//
+// only where each shape is (sequence, frame & shape) is kept, the outline is read back from its
+// sequence when it's needed (see getShape)
+
+enum {
+	SHAPE_DESCRIPTOR_HU = 0,
+	SHAPE_DESCRIPTOR_ASPECT = 7,
+	SHAPE_DESCRIPTOR_COMPLEXITY,
+	SHAPE_DESCRIPTOR_AREA,
+	SHAPE_DESCRIPTOR_COLOR,
+	SHAPE_DESCRIPTOR_SIZE = SHAPE_DESCRIPTOR_COLOR + 3
+};
+
+#define SHAPE_LIBRARY_VERSION 1
+
+struct ShapeLibraryEntry {
+
+	float descriptor[SHAPE_DESCRIPTOR_SIZE];
+	uint32_t sequence;
+	uint32_t frame;
+	uint32_t shape; // in the frame
+};
+
+// a shape that was found
+struct ShapeLibraryMatch {
+
+	float distance;
+	int sequence;
+	int frame;
+	int shape;
+};
+
+//--------------------------------------------------------------
+
+class ShapeLibrary {
+
+public:
+
+	//--------------------------------------------------------------
+
+	ShapeLibrary(){
+
+		bBuilt = true;
+		setWeights(1, 1, 1);
+	}
+
+	~ShapeLibrary(){
+
+		clear();
+	}
+
+	//--------------------------------------------------------------
+
+	void clear(){
+
+		closeReaders();
+
+		sequencePaths.clear();
+		entries.clear();
+		splitDims.clear();
+		bBuilt = true;
+	}
+
+	//--------------------------------------------------------------
+
+	// how much the outline, the size & the color count when comparing shapes (0 ignores it)
+
+	void setWeights(float shapeWeight, float sizeWeight, float colorWeight){
+
+		for(int i=0; i<SHAPE_DESCRIPTOR_SIZE; i++){
+
+			if( i == SHAPE_DESCRIPTOR_AREA ) weights[i] = sizeWeight;
+			else if( i >= SHAPE_DESCRIPTOR_COLOR ) weights[i] = colorWeight;
+			else weights[i] = shapeWeight;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// add the shapes of a finished shape sequence (from the extraction cache or a batch)
+	// frameStep only adds every so many frames, a tracked shape barely changes from one frame to the next
+	// repeated frames are skipped, their shapes are already in the frame before them
+
+	bool addSequence(string filePath, int frameStep = 1){
+
+		ShapeSequenceReader reader;
+
+		if( !reader.open(filePath) ) return false;
+
+		int sequence = sequencePaths.size();
+		sequencePaths.push_back(filePath);
+
+		ShapeCollection frame;
+
+		for(int f=0; f<reader.getNumFrames(); f+=MAX(1, frameStep)){
+
+			if( reader.getStoredFrame(f) != f ) continue;
+
+			reader.getFrame(f, frame);
+
+			for(int i=0; i<frame.shapes.size(); i++){
+
+				ShapeLibraryEntry entry;
+				describe(frame.shapes[i], frame.colors[i], entry.descriptor);
+				entry.sequence = sequence;
+				entry.frame = f;
+				entry.shape = i;
+
+				entries.push_back(entry);
+			}
+		}
+
+		bBuilt = false;
+
+		return true;
+	}
+
+	int getNumSequences(){
+
+		return sequencePaths.size();
+	}
+
+	int getNumShapes(){
+
+		return entries.size();
+	}
+
+	//--------------------------------------------------------------
+
+	// find the k shapes that look most like a shape, nearest first
+
+	void findSimilar(ofxCvBlob & shape, ofColor & color, int k, vector<ShapeLibraryMatch> & matches){
+
+		float descriptor[SHAPE_DESCRIPTOR_SIZE];
+		describe(shape, color, descriptor);
+
+		findNearest(descriptor, k, matches);
+	}
+
+	//--------------------------------------------------------------
+
+	void findNearest(float * descriptor, int k, vector<ShapeLibraryMatch> & matches){
+
+		matches.clear();
+
+		if( k <= 0 || entries.size() == 0 ) return;
+
+		build();
+
+		// the nearest shapes found so far, the furthest of them on top
+		priority_queue< pair<float, int> > nearest;
+
+		search(0, entries.size(), descriptor, k, nearest);
+
+		matches.resize(nearest.size());
+
+		for(int i=matches.size()-1; i>=0; i--){
+
+			ShapeLibraryEntry & entry = entries[nearest.top().second];
+
+			matches[i].distance = sqrt(nearest.top().first);
+			matches[i].sequence = entry.sequence;
+			matches[i].frame = entry.frame;
+			matches[i].shape = entry.shape;
+
+			nearest.pop();
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// read a shape that was found back from its sequence
+
+	bool getShape(ShapeLibraryMatch & match, ofxCvBlob & shape, ofColor & color){
+
+		if( match.sequence < 0 || match.sequence >= sequencePaths.size() ) return false;
+
+		// the sequences are opened when they're first used
+		if( readers.size() < sequencePaths.size() ) readers.resize(sequencePaths.size(), (ShapeSequenceReader*)NULL);
+
+		if( readers[match.sequence] == NULL ){
+
+			readers[match.sequence] = new ShapeSequenceReader();
+
+			if( !readers[match.sequence]->open(sequencePaths[match.sequence]) ) return false;
+		}
+
+		ShapeSequenceReader & reader = *readers[match.sequence];
+
+		if( !reader.isOpen() || match.frame >= reader.getNumFrames() ) return false;
+
+		int id;
+		ofRectangle boundingRect;
+		float area;
+
+		reader.getShapeInfo(match.frame, match.shape, color, id, boundingRect, area);
+		reader.getShape(match.frame, match.shape, shape);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// the library is saved already built, so loading it is just reading it
+
+	bool save(string filePath){
+
+		build();
+
+		FILE * file = fopen(ofToDataPath(filePath).c_str(), "wb");
+
+		if( file == NULL ){
+
+			ofLog(OF_LOG_ERROR, "Failed to create shape library " + filePath);
+			return false;
+		}
+
+		uint32_t header[3] = { SHAPE_LIBRARY_VERSION, (uint32_t)sequencePaths.size(), (uint32_t)entries.size() };
+
+		fwrite("APSL", 1, 4, file);
+		fwrite(header, sizeof(header), 1, file);
+
+		for(int i=0; i<sequencePaths.size(); i++){
+
+			uint32_t length = sequencePaths[i].size();
+			fwrite(&length, sizeof(length), 1, file);
+			fwrite(sequencePaths[i].c_str(), 1, length, file);
+		}
+
+		if( entries.size() > 0 ){
+
+			fwrite(&entries[0], sizeof(ShapeLibraryEntry), entries.size(), file);
+			fwrite(&splitDims[0], 1, splitDims.size(), file);
+		}
+
+		fclose(file);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	bool load(string filePath){
+
+		clear();
+
+		FILE * file = fopen(ofToDataPath(filePath).c_str(), "rb");
+
+		if( file == NULL ) return false;
+
+		char magic[4];
+		uint32_t header[3];
+
+		bool bValid = fread(magic, 1, 4, file) == 4 && memcmp(magic, "APSL", 4) == 0
+			&& fread(header, sizeof(header), 1, file) == 1 && header[0] == SHAPE_LIBRARY_VERSION;
+
+		for(int i=0; bValid && i<header[1]; i++){
+
+			uint32_t length;
+			bValid = fread(&length, sizeof(length), 1, file) == 1 && length < 4096;
+
+			if( bValid ){
+
+				vector<char> path(length + 1, 0);
+				bValid = fread(&path[0], 1, length, file) == length;
+				sequencePaths.push_back(&path[0]);
+			}
+		}
+
+		if( bValid && header[2] > 0 ){
+
+			entries.resize(header[2]);
+			splitDims.resize(header[2]);
+
+			bValid = fread(&entries[0], sizeof(ShapeLibraryEntry), entries.size(), file) == entries.size()
+				&& fread(&splitDims[0], 1, splitDims.size(), file) == splitDims.size();
+		}
+
+		fclose(file);
+
+		if( !bValid ){
+
+			ofLog(OF_LOG_WARNING, "Not a valid shape library " + filePath);
+			clear();
+		}
+
+		return bValid;
+	}
+
+	//--------------------------------------------------------------
+
+	// put the shapes in kd-tree order: each range is split at its middle shape, along the part
+	// of the descriptor that's most spread out in the range (it's done before searching anyway)
+
+	void build(){
+
+		if( bBuilt ) return;
+
+		splitDims.assign(entries.size(), 0);
+		buildRange(0, entries.size());
+
+		bBuilt = true;
+	}
+
+	//--------------------------------------------------------------
+
+	static void describe(ofxCvBlob & shape, ofColor & color, float * descriptor){
+
+		memset(descriptor, 0, SHAPE_DESCRIPTOR_SIZE * sizeof(float));
+
+		int numPts = shape.pts.size();
+
+		// the moments of the area inside the outline (from its edges), up to the 3rd order
+		// from the first point, which doesn't change the central moments & keeps the numbers small
+		double m00 = 0, m10 = 0, m01 = 0, m20 = 0, m11 = 0, m02 = 0, m30 = 0, m21 = 0, m12 = 0, m03 = 0;
+		double perimeter = 0;
+
+		for(int i=0; i<numPts; i++){
+
+			double x0 = shape.pts[i].x - shape.pts[0].x;
+			double y0 = shape.pts[i].y - shape.pts[0].y;
+			double x1 = shape.pts[(i + 1) % numPts].x - shape.pts[0].x;
+			double y1 = shape.pts[(i + 1) % numPts].y - shape.pts[0].y;
+
+			double a = x0 * y1 - x1 * y0;
+
+			m00 += a;
+			m10 += a * (x0 + x1);
+			m01 += a * (y0 + y1);
+			m20 += a * (x0 * x0 + x0 * x1 + x1 * x1);
+			m02 += a * (y0 * y0 + y0 * y1 + y1 * y1);
+			m11 += a * (2 * x0 * y0 + x0 * y1 + x1 * y0 + 2 * x1 * y1);
+			m30 += a * (x0 * x0 * x0 + x0 * x0 * x1 + x0 * x1 * x1 + x1 * x1 * x1);
+			m03 += a * (y0 * y0 * y0 + y0 * y0 * y1 + y0 * y1 * y1 + y1 * y1 * y1);
+			m21 += a * (x0 * x0 * (3 * y0 + y1) + 2 * x0 * x1 * (y0 + y1) + x1 * x1 * (y0 + 3 * y1));
+			m12 += a * (y0 * y0 * (3 * x0 + x1) + 2 * y0 * y1 * (x0 + x1) + y1 * y1 * (x0 + 3 * x1));
+
+			perimeter += sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+		}
+
+		m00 /= 2;  m10 /= 6;  m01 /= 6;  m20 /= 12;  m02 /= 12;  m11 /= 24;
+		m30 /= 20; m03 /= 20; m21 /= 60; m12 /= 60;
+
+		// the outline can go either way round
+		if( m00 < 0 ){
+
+			m00 = -m00; m10 = -m10; m01 = -m01; m20 = -m20; m02 = -m02;
+			m11 = -m11; m30 = -m30; m03 = -m03; m21 = -m21; m12 = -m12;
+		}
+
+		if( m00 > 0.5 ){
+
+			double cx = m10 / m00;
+			double cy = m01 / m00;
+
+			// central moments, scaled by the area so the size doesn't matter
+			double s2 = m00 * m00;
+			double s3 = s2 * sqrt(m00);
+
+			double n20 = (m20 - cx * m10) / s2;
+			double n02 = (m02 - cy * m01) / s2;
+			double n11 = (m11 - cx * m01) / s2;
+			double n30 = (m30 - 3 * cx * m20 + 2 * cx * cx * m10) / s3;
+			double n03 = (m03 - 3 * cy * m02 + 2 * cy * cy * m01) / s3;
+			double n21 = (m21 - 2 * cx * m11 - cy * m20 + 2 * cx * cx * m01) / s3;
+			double n12 = (m12 - 2 * cy * m11 - cx * m02 + 2 * cy * cy * m10) / s3;
+
+			double a = n30 + n12;
+			double b = n21 + n03;
+			double c = n30 - 3 * n12;
+			double d = 3 * n21 - n03;
+
+			double hu[7];
+			hu[0] = n20 + n02;
+			hu[1] = (n20 - n02) * (n20 - n02) + 4 * n11 * n11;
+			hu[2] = c * c + d * d;
+			hu[3] = a * a + b * b;
+			hu[4] = c * a * (a * a - 3 * b * b) + d * b * (3 * a * a - b * b);
+			hu[5] = (n20 - n02) * (a * a - b * b) + 4 * n11 * a * b;
+			hu[6] = d * a * (a * a - 3 * b * b) - c * b * (3 * a * a - b * b);
+
+			// a signed log that goes smoothly through 0 (anything under 1e-9 is about 0)
+			for(int i=0; i<7; i++){
+
+				float value = log10(1 + fabs(hu[i]) * 1e9);
+				descriptor[SHAPE_DESCRIPTOR_HU + i] = ( hu[i] < 0 ) ? -value : value;
+			}
+
+			descriptor[SHAPE_DESCRIPTOR_COMPLEXITY] = log2(MAX(1.0, perimeter * perimeter / (4 * PI * m00)));
+		}
+
+		descriptor[SHAPE_DESCRIPTOR_ASPECT] = log2(MAX(1.0f, shape.boundingRect.width) / MAX(1.0f, shape.boundingRect.height));
+		descriptor[SHAPE_DESCRIPTOR_AREA] = log10(MAX(1.0, m00));
+
+		descriptor[SHAPE_DESCRIPTOR_COLOR] = color.r / 64.0f;
+		descriptor[SHAPE_DESCRIPTOR_COLOR + 1] = color.g / 64.0f;
+		descriptor[SHAPE_DESCRIPTOR_COLOR + 2] = color.b / 64.0f;
+	}
+
+	//--------------------------------------------------------------
+
+	// sorts shapes by one part of their descriptor
+	struct CompareDim {
+
+		CompareDim(int d) : dim(d) {}
+
+		bool operator()(const ShapeLibraryEntry & a, const ShapeLibraryEntry & b) const {
+
+			return a.descriptor[dim] < b.descriptor[dim];
+		}
+
+		int dim;
+	};
+
+	//--------------------------------------------------------------
+
+	void buildRange(int first, int last){
+
+		if( last - first <= 1 ) return;
+
+		// split along the part that's most spread out
+		float low[SHAPE_DESCRIPTOR_SIZE];
+		float high[SHAPE_DESCRIPTOR_SIZE];
+
+		for(int d=0; d<SHAPE_DESCRIPTOR_SIZE; d++){
+
+			low[d] = high[d] = entries[first].descriptor[d];
+		}
+
+		for(int i=first+1; i<last; i++){
+
+			for(int d=0; d<SHAPE_DESCRIPTOR_SIZE; d++){
+
+				low[d] = MIN(low[d], entries[i].descriptor[d]);
+				high[d] = MAX(high[d], entries[i].descriptor[d]);
+			}
+		}
+
+		int dim = 0;
+
+		for(int d=1; d<SHAPE_DESCRIPTOR_SIZE; d++){
+
+			if( high[d] - low[d] > high[dim] - low[dim] ) dim = d;
+		}
+
+		int middle = (first + last) / 2;
+
+		nth_element(entries.begin() + first, entries.begin() + middle, entries.begin() + last, CompareDim(dim));
+		splitDims[middle] = dim;
+
+		buildRange(first, middle);
+		buildRange(middle + 1, last);
+	}
+
+	//--------------------------------------------------------------
+
+	float getDistance(float * descriptor, ShapeLibraryEntry & entry){
+
+		float distance = 0;
+
+		for(int d=0; d<SHAPE_DESCRIPTOR_SIZE; d++){
+
+			float diff = descriptor[d] - entry.descriptor[d];
+			distance += weights[d] * diff * diff;
+		}
+
+		return distance;
+	}
+
+	//--------------------------------------------------------------
+
+	// look in the side of each split the descriptor is on first, then only in the other side
+	// if the split is nearer than the furthest of the k nearest found so far
+
+	void search(int first, int last, float * descriptor, int k, priority_queue< pair<float, int> > & nearest){
+
+		if( first >= last ) return;
+
+		int middle = (first + last) / 2;
+
+		float distance = getDistance(descriptor, entries[middle]);
+
+		if( nearest.size() < k ){
+
+			nearest.push(make_pair(distance, middle));
+
+		} else if( distance < nearest.top().first ){
+
+			nearest.pop();
+			nearest.push(make_pair(distance, middle));
+		}
+
+		if( last - first == 1 ) return;
+
+		int dim = splitDims[middle];
+		float diff = descriptor[dim] - entries[middle].descriptor[dim];
+
+		if( diff < 0 ) search(first, middle, descriptor, k, nearest);
+		else search(middle + 1, last, descriptor, k, nearest);
+
+		if( nearest.size() < k || weights[dim] * diff * diff < nearest.top().first ){
+
+			if( diff < 0 ) search(middle + 1, last, descriptor, k, nearest);
+			else search(first, middle, descriptor, k, nearest);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void closeReaders(){
+
+		for(int i=0; i<readers.size(); i++){
+
+			delete readers[i];
+		}
+
+		readers.clear();
+	}
+
+	float weights[SHAPE_DESCRIPTOR_SIZE];
+
+	vector<string> sequencePaths;
+	vector<ShapeSequenceReader*> readers; // NULL until a sequence is used
+
+	vector<ShapeLibraryEntry> entries; // in kd-tree order once it's built
+	vector<unsigned char> splitDims; // the part each range is split along, at its middle shape
+	bool bBuilt;
+};
@@ -0,0 +1,892 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeCollection.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// a compact binary file holding the shapes of every frame of a movie
+// it's much faster to write & read than a folder of xml files
+//
+// the file starts with a header, then the frames one after another, then an index
+// the index says where each frame starts, so any frame can be read without reading the others,
+// & sums up each frame's shapes, so frames can be picked out without reading them at all
+// (each frame also starts with a table of where its shapes are, so one shape can be read on its own)
+//
+// most shapes barely change from one frame to the next, so a shape that was in the last frame
+// (the same id, see ShapeTracker) is saved as how far it moved plus the runs of points that changed
+// every so often there's a keyframe where every shape is saved in full, so reading a frame
+// never has to go back further than the last keyframe
+//
+// header:  "APSQ", version, number of frames, keyframe interval, offset of the index
+// frame:   number of shapes (the top bit is set if the frame repeats the one before it,
+//          then nothing else follows unless it's a keyframe or the number of shapes changed,
+//          e.g. a still frame in motion detection has no shapes),
+//          then for each shape: where its record starts (from the end of the table), area,
+//          then for each shape's record: color (rgb + type), id, bounding rect, then
+//          full shape:   number of points, points (x, y)
+//          moved shape:  index of the shape in the last frame, offset (x, y), number of runs,
+//                        then for each run: first point, number of points, points (x, y)
+// index:   for each frame: the offset & size in bytes, number of shapes, the rect around all of
+//          the shapes, the smallest & largest area, the lowest & highest of each color channel
+
+#define SHAPE_SEQUENCE_VERSION 5
+#define SHAPE_FRAME_REPEATED 0x80000000
+
+struct ShapeSequenceHeader {
+
+	char magic[4];
+	uint32_t version;
+	uint32_t numFrames;
+	uint32_t keyframeInterval;
+	uint64_t indexOffset;
+};
+
+struct ShapeSequenceIndexEntry {
+
+	uint64_t offset;
+	uint64_t size;
+
+	// a summary of the frame's shapes
+	uint32_t numShapes;
+	float bounds[4]; // x, y, width, height
+	float minArea;
+	float maxArea;
+	unsigned char minColor[3];
+	unsigned char maxColor[3];
+};
+
+enum { SHAPE_RECORD_FULL = 0, SHAPE_RECORD_MOVED };
+
+//--------------------------------------------------------------
+
+// writes frames to the end of the file as they're added
+// the index is written when the file is closed
+
+class ShapeSequenceWriter {
+
+public:
+
+	ShapeSequenceWriter(){
+
+		file = NULL;
+		keyframeInterval = 30;
+	}
+
+	~ShapeSequenceWriter(){
+
+		close();
+	}
+
+	//--------------------------------------------------------------
+
+	// how often every shape is saved in full (1 saves every frame in full)
+
+	void setKeyframeInterval(int interval){
+
+		keyframeInterval = MAX(1, interval);
+	}
+
+	//--------------------------------------------------------------
+
+	bool open(string filePath){
+
+		close();
+
+		file = fopen(ofToDataPath(filePath).c_str(), "wb");
+
+		if( file == NULL ){
+
+			ofLog(OF_LOG_ERROR, "Failed to create shape sequence " + filePath);
+			return false;
+		}
+
+		// leave room for the header, it's filled in at the end
+		ShapeSequenceHeader header;
+		memset(&header, 0, sizeof(header));
+		fwrite(&header, sizeof(header), 1, file);
+
+		index.clear();
+		offset = sizeof(header);
+		memset(&summary, 0, sizeof(summary));
+
+		previousShapes.clear();
+		previousColors.clear();
+		previousIds.clear();
+		previousIdList.clear();
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	bool isOpen(){
+
+		return file != NULL;
+	}
+
+	int getNumFrames(){
+
+		return index.size();
+	}
+
+	// make sure the frames added so far are in the file (so they can be read before it's closed)
+
+	void flush(){
+
+		if( file != NULL ) fflush(file);
+	}
+
+	//--------------------------------------------------------------
+
+	void addFrame(ShapeCollection & frame){
+
+		if( file == NULL ) return;
+
+		bool bKeyframe = ( index.size() % keyframeInterval == 0 );
+
+		buffer.clear();
+		records.clear();
+
+		// a repeated frame only needs its shapes saved if it's a keyframe
+		// (it has the same shapes as the frame before, so it has the same summary too)
+		// unless it doesn't keep them, like a still frame with no motion
+		if( frame.bRepeated && !bKeyframe && frame.shapes.size() == previousShapes.size() ){
+
+			appendValue(buffer, (uint32_t)(SHAPE_FRAME_REPEATED | frame.shapes.size()));
+			writeBuffer();
+			return;
+		}
+
+		appendValue(buffer, (uint32_t)(( frame.bRepeated ? SHAPE_FRAME_REPEATED : 0 ) | frame.shapes.size()));
+
+		memset(&summary, 0, sizeof(summary));
+		summary.numShapes = frame.shapes.size();
+
+		for(int i=0; i<frame.shapes.size(); i++){
+
+			ofxCvBlob & shape = frame.shapes[i];
+			int id = ( i < frame.ids.size() ) ? frame.ids[i] : -1;
+
+			// look for the same shape in the last frame
+			int previous = -1;
+
+			if( !bKeyframe && id >= 0 ){
+
+				map<int, int>::iterator it = previousIds.find(id);
+				if( it != previousIds.end() ) previous = it->second;
+			}
+
+			float area = getArea(shape);
+			addToSummary(shape, area, frame.colors[i], i == 0);
+
+			// the table entry
+			appendValue(buffer, (uint32_t)records.size());
+			appendValue(buffer, area);
+
+			int typePos = records.size() + 3;
+
+			unsigned char color[4] = { frame.colors[i].r, frame.colors[i].g, frame.colors[i].b, SHAPE_RECORD_FULL };
+			records.insert(records.end(), color, color + 4);
+
+			appendValue(records, (int32_t)id);
+
+			appendValue(records, (float)shape.boundingRect.x);
+			appendValue(records, (float)shape.boundingRect.y);
+			appendValue(records, (float)shape.boundingRect.width);
+			appendValue(records, (float)shape.boundingRect.height);
+
+			if( previous >= 0 && appendMovedShape(shape, previous) ){
+
+				records[typePos] = SHAPE_RECORD_MOVED;
+
+			} else {
+
+				appendValue(records, (uint32_t)shape.pts.size());
+
+				for(int j=0; j<shape.pts.size(); j++){
+
+					appendValue(records, (float)shape.pts[j].x);
+					appendValue(records, (float)shape.pts[j].y);
+				}
+			}
+		}
+
+		buffer.insert(buffer.end(), records.begin(), records.end());
+		writeBuffer();
+
+		// remember this frame's shapes for the next frame
+		previousShapes = frame.shapes;
+		previousColors = frame.colors;
+		previousIdList = frame.ids;
+		previousIds.clear();
+
+		for(int i=0; i<frame.ids.size(); i++){
+
+			if( frame.ids[i] >= 0 ) previousIds[frame.ids[i]] = i;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// add a frame that's the same as the last one added
+
+	void addRepeatedFrame(){
+
+		if( file == NULL ) return;
+
+		ShapeCollection frame;
+
+		for(int i=0; i<previousShapes.size(); i++){
+
+			frame.addShape(previousShapes[i]);
+			frame.addColor(previousColors[i]);
+		}
+
+		frame.ids = previousIdList;
+		frame.bRepeated = true;
+
+		addFrame(frame);
+	}
+
+	//--------------------------------------------------------------
+
+	void writeBuffer(){
+
+		ShapeSequenceIndexEntry entry = summary;
+		entry.offset = offset;
+		entry.size = buffer.size();
+		index.push_back(entry);
+
+		if( buffer.size() > 0 ) fwrite(&buffer[0], 1, buffer.size(), file);
+		offset += buffer.size();
+	}
+
+	//--------------------------------------------------------------
+
+	// save a shape as the offset from its last position & the points that changed
+	// returns false (& adds nothing) if that wouldn't be smaller than saving the whole shape
+
+	bool appendMovedShape(ofxCvBlob & shape, int previous){
+
+		ofxCvBlob & before = previousShapes[previous];
+		int numPts = shape.pts.size();
+
+		if( before.pts.size() != numPts ) return false;
+
+		float offsetX = shape.boundingRect.x - before.boundingRect.x;
+		float offsetY = shape.boundingRect.y - before.boundingRect.y;
+
+		// find the runs of points that aren't just moved by the offset
+		// runs with one point between them are joined, starting a run costs as much as a point
+		runs.clear();
+
+		for(int j=0; j<numPts; j++){
+
+			if( shape.pts[j].x == before.pts[j].x + offsetX && shape.pts[j].y == before.pts[j].y + offsetY ) continue;
+
+			if( runs.size() > 0 && j - (runs.back().first + runs.back().second) <= 1 ){
+
+				runs.back().second = j - runs.back().first + 1;
+
+			} else {
+
+				runs.push_back( make_pair(j, 1) );
+			}
+		}
+
+		int numChanged = 0;
+
+		for(int r=0; r<runs.size(); r++){
+
+			numChanged += runs[r].second;
+		}
+
+		// in bytes, not counting the color, id & bounding rect
+		int movedSize = 16 + runs.size() * 8 + numChanged * 8;
+		int fullSize = 4 + numPts * 8;
+
+		if( movedSize >= fullSize ) return false;
+
+		appendValue(records, (uint32_t)previous);
+		appendValue(records, offsetX);
+		appendValue(records, offsetY);
+		appendValue(records, (uint32_t)runs.size());
+
+		for(int r=0; r<runs.size(); r++){
+
+			appendValue(records, (uint32_t)runs[r].first);
+			appendValue(records, (uint32_t)runs[r].second);
+
+			for(int j=runs[r].first; j<runs[r].first + runs[r].second; j++){
+
+				appendValue(records, (float)shape.pts[j].x);
+				appendValue(records, (float)shape.pts[j].y);
+			}
+		}
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// the area inside a shape's outline
+
+	static float getArea(ofxCvBlob & shape){
+
+		float area = 0;
+		int numPts = shape.pts.size();
+
+		for(int j=0; j<numPts; j++){
+
+			ofPoint & a = shape.pts[j];
+			ofPoint & b = shape.pts[(j + 1) % numPts];
+
+			area += a.x * b.y - b.x * a.y;
+		}
+
+		return fabs(area) / 2;
+	}
+
+	//--------------------------------------------------------------
+
+	// grow the frame's summary to take in a shape
+
+	void addToSummary(ofxCvBlob & shape, float area, ofColor & color, bool bFirst){
+
+		ofRectangle & rect = shape.boundingRect;
+
+		if( bFirst ){
+
+			summary.bounds[0] = rect.x;
+			summary.bounds[1] = rect.y;
+			summary.bounds[2] = rect.width;
+			summary.bounds[3] = rect.height;
+			summary.minArea = summary.maxArea = area;
+
+			for(int c=0; c<3; c++){
+
+				summary.minColor[c] = summary.maxColor[c] = color[c];
+			}
+
+			return;
+		}
+
+		float right = MAX(summary.bounds[0] + summary.bounds[2], rect.x + rect.width);
+		float bottom = MAX(summary.bounds[1] + summary.bounds[3], rect.y + rect.height);
+
+		summary.bounds[0] = MIN(summary.bounds[0], rect.x);
+		summary.bounds[1] = MIN(summary.bounds[1], rect.y);
+		summary.bounds[2] = right - summary.bounds[0];
+		summary.bounds[3] = bottom - summary.bounds[1];
+
+		summary.minArea = MIN(summary.minArea, area);
+		summary.maxArea = MAX(summary.maxArea, area);
+
+		for(int c=0; c<3; c++){
+
+			summary.minColor[c] = MIN(summary.minColor[c], color[c]);
+			summary.maxColor[c] = MAX(summary.maxColor[c], color[c]);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// write the index & header, then close the file
+
+	void close(){
+
+		if( file == NULL ) return;
+
+		if( index.size() > 0 ) fwrite(&index[0], sizeof(ShapeSequenceIndexEntry), index.size(), file);
+
+		ShapeSequenceHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "APSQ", 4);
+		header.version = SHAPE_SEQUENCE_VERSION;
+		header.numFrames = index.size();
+		header.keyframeInterval = keyframeInterval;
+		header.indexOffset = offset;
+
+		fseek(file, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, file);
+
+		fclose(file);
+		file = NULL;
+	}
+
+	//--------------------------------------------------------------
+
+	template <class T>
+	static void appendValue(vector<unsigned char> & data, T value){
+
+		unsigned char * bytes = (unsigned char*)&value;
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	FILE * file;
+	uint64_t offset;
+	vector<ShapeSequenceIndexEntry> index;
+	vector<unsigned char> buffer;
+	vector<unsigned char> records; // the shape records of the frame being added
+	ShapeSequenceIndexEntry summary; // of the last frame added
+
+	int keyframeInterval;
+	vector<ofxCvBlob> previousShapes;
+	vector<ofColor> previousColors;
+	vector<int> previousIdList;
+	map<int, int> previousIds; // shape id -> index in previousShapes
+	vector< pair<int, int> > runs;
+};
+
+//--------------------------------------------------------------
+
+// reads frames from a shape sequence file
+// the file is memory-mapped, so opening is instant & frames are only read from disk when they're used
+// moved shapes need the frame before them, so the last frame read is kept:
+// reading frames in order reads each frame once, jumping reads forward from the keyframe before it
+
+class ShapeSequenceReader {
+
+public:
+
+	ShapeSequenceReader(){
+
+		data = NULL;
+		dataSize = 0;
+		indexData = NULL;
+		numFrames = 0;
+		keyframeInterval = 1;
+		lastFrameRead = -1;
+		bLastRepeated = false;
+	}
+
+	~ShapeSequenceReader(){
+
+		close();
+	}
+
+	//--------------------------------------------------------------
+
+	bool open(string filePath){
+
+		close();
+
+		int fd = ::open(ofToDataPath(filePath).c_str(), O_RDONLY);
+
+		if( fd < 0 ) return false;
+
+		struct stat fileInfo;
+
+		if( fstat(fd, &fileInfo) != 0 || fileInfo.st_size < sizeof(ShapeSequenceHeader) ){
+
+			::close(fd);
+			return false;
+		}
+
+		dataSize = fileInfo.st_size;
+		void * mapped = mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+
+		// the mapping stays valid after the file is closed
+		::close(fd);
+
+		if( mapped == MAP_FAILED ){
+
+			dataSize = 0;
+			return false;
+		}
+
+		data = (unsigned char*)mapped;
+
+		// check that it's a complete shape sequence
+		ShapeSequenceHeader header;
+		memcpy(&header, data, sizeof(header));
+
+		if( memcmp(header.magic, "APSQ", 4) != 0 || header.version != SHAPE_SEQUENCE_VERSION
+			|| header.indexOffset + header.numFrames * sizeof(ShapeSequenceIndexEntry) > dataSize ){
+
+			ofLog(OF_LOG_WARNING, "Not a valid shape sequence " + filePath);
+			close();
+			return false;
+		}
+
+		numFrames = header.numFrames;
+		keyframeInterval = MAX(1, header.keyframeInterval);
+		indexData = data + header.indexOffset;
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// read a file that's still being written, using the index its writer keeps in memory
+	// (the writer has to be flushed first)
+	// call it again after more frames are written, the last frame read is kept so reading carries on
+	// the writer's index moves when it grows, so the entries are copied (only the new ones each time)
+
+	bool openUnfinished(int fd, vector<ShapeSequenceIndexEntry> & index, int interval){
+
+		unmap();
+
+		struct stat fileInfo;
+
+		if( index.size() == 0 || fstat(fd, &fileInfo) != 0 ) return false;
+
+		dataSize = fileInfo.st_size;
+		void * mapped = mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+
+		if( mapped == MAP_FAILED ){
+
+			dataSize = 0;
+			return false;
+		}
+
+		data = (unsigned char*)mapped;
+
+		// a different writer starts again
+		if( index.size() < unfinishedIndex.size() ) unfinishedIndex.clear();
+
+		unfinishedIndex.insert(unfinishedIndex.end(), index.begin() + unfinishedIndex.size(), index.end());
+
+		indexData = (unsigned char*)&unfinishedIndex[0];
+		numFrames = unfinishedIndex.size();
+		keyframeInterval = MAX(1, interval);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	void close(){
+
+		unmap();
+
+		unfinishedIndex.clear();
+
+		lastFrameRead = -1;
+		lastShapes.clear();
+		lastColors.clear();
+		lastIds.clear();
+		bLastRepeated = false;
+	}
+
+	void unmap(){
+
+		if( data != NULL ){
+
+			munmap(data, dataSize);
+			data = NULL;
+		}
+
+		dataSize = 0;
+		numFrames = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	bool isOpen(){
+
+		return data != NULL;
+	}
+
+	int getNumFrames(){
+
+		return numFrames;
+	}
+
+	//--------------------------------------------------------------
+
+	// read a frame's shapes into a collection
+
+	bool getFrame(int frameIndex, ShapeCollection & frame){
+
+		frame = ShapeCollection();
+
+		if( frameIndex < 0 || frameIndex >= numFrames ) return false;
+
+		if( lastFrameRead != frameIndex ){
+
+			// carry on from the last frame we read if we can, otherwise start at the keyframe
+			int first = frameIndex - frameIndex % keyframeInterval;
+
+			if( lastFrameRead >= first && lastFrameRead < frameIndex ) first = lastFrameRead + 1;
+
+			for(int i=first; i<=frameIndex; i++){
+
+				readShapes(i);
+			}
+		}
+
+		for(int i=0; i<lastShapes.size(); i++){
+
+			frame.addShape(lastShapes[i]);
+			frame.addColor(lastColors[i]);
+			frame.ids.push_back(lastIds[i]);
+		}
+
+		frame.bRepeated = bLastRepeated;
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// read the shapes of a frame, using the shapes of the frame before it for moved shapes
+
+	void readShapes(int frameIndex){
+
+		ShapeSequenceIndexEntry entry;
+		memcpy(&entry, indexData + frameIndex * sizeof(entry), sizeof(entry));
+
+		const unsigned char * pos = data + entry.offset;
+
+		uint32_t numShapes = readValue<uint32_t>(pos);
+
+		bLastRepeated = ( numShapes & SHAPE_FRAME_REPEATED ) != 0;
+		numShapes &= ~SHAPE_FRAME_REPEATED;
+
+		// between keyframes a repeated frame just keeps the last frame's shapes
+		// (if it has as many, otherwise it was saved in full)
+		if( bLastRepeated && frameIndex % keyframeInterval != 0 && numShapes == lastShapes.size() ){
+
+			lastFrameRead = frameIndex;
+			return;
+		}
+
+		// the records follow each other, so the table isn't needed here
+		pos += numShapes * 8;
+
+		vector<ofxCvBlob> shapes(numShapes);
+		vector<ofColor> colors(numShapes);
+		vector<int> ids(numShapes);
+
+		for(int i=0; i<numShapes; i++){
+
+			colors[i].set(pos[0], pos[1], pos[2]);
+			int type = pos[3];
+			pos += 4;
+
+			ids[i] = readValue<int32_t>(pos);
+
+			ofxCvBlob & shape = shapes[i];
+
+			float x = readValue<float>(pos);
+			float y = readValue<float>(pos);
+			float w = readValue<float>(pos);
+			float h = readValue<float>(pos);
+			shape.boundingRect.set(x, y, w, h);
+
+			if( type == SHAPE_RECORD_MOVED ){
+
+				// move the shape from the last frame, then fill in the points that changed
+				ofxCvBlob & before = lastShapes[readValue<uint32_t>(pos)];
+				float offsetX = readValue<float>(pos);
+				float offsetY = readValue<float>(pos);
+
+				shape.nPts = before.nPts;
+				shape.pts.resize(shape.nPts);
+
+				for(int j=0; j<shape.nPts; j++){
+
+					shape.pts[j].set(before.pts[j].x + offsetX, before.pts[j].y + offsetY);
+				}
+
+				uint32_t numRuns = readValue<uint32_t>(pos);
+
+				for(int r=0; r<numRuns; r++){
+
+					uint32_t start = readValue<uint32_t>(pos);
+					uint32_t count = readValue<uint32_t>(pos);
+
+					for(int j=start; j<start + count; j++){
+
+						float px = readValue<float>(pos);
+						float py = readValue<float>(pos);
+						shape.pts[j].set(px, py);
+					}
+				}
+
+			} else {
+
+				shape.nPts = readValue<uint32_t>(pos);
+				shape.pts.resize(shape.nPts);
+
+				for(int j=0; j<shape.nPts; j++){
+
+					float px = readValue<float>(pos);
+					float py = readValue<float>(pos);
+					shape.pts[j].set(px, py);
+				}
+			}
+		}
+
+		lastShapes.swap(shapes);
+		lastColors.swap(colors);
+		lastIds.swap(ids);
+		lastFrameRead = frameIndex;
+	}
+
+	//--------------------------------------------------------------
+
+	// the summary of a frame's shapes, from the index (nothing is read from the frame itself)
+
+	ShapeSequenceIndexEntry getSummary(int frameIndex){
+
+		ShapeSequenceIndexEntry entry;
+		memcpy(&entry, indexData + frameIndex * sizeof(entry), sizeof(entry));
+
+		return entry;
+	}
+
+	//--------------------------------------------------------------
+
+	// a repeated frame only has a marker between keyframes, its shapes are in a frame before it
+	// get the frame a frame's shapes are actually in
+
+	int getStoredFrame(int frameIndex){
+
+		while( frameIndex % keyframeInterval != 0 ){
+
+			const unsigned char * pos = data + getSummary(frameIndex).offset;
+
+			if( (readValue<uint32_t>(pos) & SHAPE_FRAME_REPEATED) == 0 ) break;
+
+			frameIndex--;
+		}
+
+		return frameIndex;
+	}
+
+	//--------------------------------------------------------------
+
+	// read one shape's color, id, bounding rect & area, without reading the rest of the frame
+
+	void getShapeInfo(int frameIndex, int shapeIndex, ofColor & color, int & id, ofRectangle & boundingRect, float & area){
+
+		const unsigned char * pos = getShapeRecord(getStoredFrame(frameIndex), shapeIndex, area);
+
+		color.set(pos[0], pos[1], pos[2]);
+		pos += 4;
+
+		id = readValue<int32_t>(pos);
+
+		float x = readValue<float>(pos);
+		float y = readValue<float>(pos);
+		float w = readValue<float>(pos);
+		float h = readValue<float>(pos);
+		boundingRect.set(x, y, w, h);
+	}
+
+	//--------------------------------------------------------------
+
+	// read one shape, without reading the rest of the frame
+	// a moved shape reads the shape it moved from in the frame before, & so on back to a full shape
+	// (never further back than the last keyframe)
+
+	void getShape(int frameIndex, int shapeIndex, ofxCvBlob & shape){
+
+		int stored = getStoredFrame(frameIndex);
+
+		float area;
+		const unsigned char * pos = getShapeRecord(stored, shapeIndex, area);
+
+		int type = pos[3];
+		pos += 8;
+
+		float x = readValue<float>(pos);
+		float y = readValue<float>(pos);
+		float w = readValue<float>(pos);
+		float h = readValue<float>(pos);
+
+		if( type == SHAPE_RECORD_MOVED ){
+
+			uint32_t previous = readValue<uint32_t>(pos);
+			float offsetX = readValue<float>(pos);
+			float offsetY = readValue<float>(pos);
+
+			getShape(stored - 1, previous, shape);
+
+			for(int j=0; j<shape.nPts; j++){
+
+				shape.pts[j].set(shape.pts[j].x + offsetX, shape.pts[j].y + offsetY);
+			}
+
+			uint32_t numRuns = readValue<uint32_t>(pos);
+
+			for(int r=0; r<numRuns; r++){
+
+				uint32_t start = readValue<uint32_t>(pos);
+				uint32_t count = readValue<uint32_t>(pos);
+
+				for(int j=start; j<start + count; j++){
+
+					float px = readValue<float>(pos);
+					float py = readValue<float>(pos);
+					shape.pts[j].set(px, py);
+				}
+			}
+
+		} else {
+
+			shape.nPts = readValue<uint32_t>(pos);
+			shape.pts.resize(shape.nPts);
+
+			for(int j=0; j<shape.nPts; j++){
+
+				float px = readValue<float>(pos);
+				float py = readValue<float>(pos);
+				shape.pts[j].set(px, py);
+			}
+		}
+
+		shape.boundingRect.set(x, y, w, h);
+	}
+
+	//--------------------------------------------------------------
+
+	// find a shape's record through the table at the start of its frame
+
+	const unsigned char * getShapeRecord(int storedFrame, int shapeIndex, float & area){
+
+		const unsigned char * frameData = data + getSummary(storedFrame).offset;
+		const unsigned char * pos = frameData;
+
+		uint32_t numShapes = readValue<uint32_t>(pos) & ~SHAPE_FRAME_REPEATED;
+
+		pos += shapeIndex * 8;
+		uint32_t recordOffset = readValue<uint32_t>(pos);
+		area = readValue<float>(pos);
+
+		return frameData + 4 + numShapes * 8 + recordOffset;
+	}
+
+	//--------------------------------------------------------------
+
+	template <class T>
+	static T readValue(const unsigned char * & pos){
+
+		T value;
+		memcpy(&value, pos, sizeof(T));
+		pos += sizeof(T);
+
+		return value;
+	}
+
+	unsigned char * data;
+	uint64_t dataSize;
+	const unsigned char * indexData; // in the file, or in unfinishedIndex
+	vector<ShapeSequenceIndexEntry> unfinishedIndex; // a copy of the writer's index for an unfinished file
+	int numFrames;
+	int keyframeInterval;
+
+	// the shapes of the last frame read
+	int lastFrameRead;
+	vector<ofxCvBlob> lastShapes;
+	vector<ofColor> lastColors;
+	vector<int> lastIds;
+	bool bLastRepeated;
+};
@@ -0,0 +1,223 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ShapeCollection.h"
+#include <float.h>
+
+// gives shapes ids that stay the same from frame to frame
+// each shape is matched with the closest shape from the last frame that's about the same
+// size & color, and takes its id (or gets a new id if nothing matches)
+//
+// the last frame's shapes are sorted into a grid, so we only compare a shape with the shapes
+// in the grid cells around it, not every shape in the frame
+// the grid is stored in a hash table, so it doesn't matter how big the frame is
+
+class ShapeTracker {
+
+public:
+
+	struct TrackedShape {
+
+		ofPoint center;
+		float size;
+		ofColor color;
+		int id;
+	};
+
+	//--------------------------------------------------------------
+
+	ShapeTracker(){
+
+		maxDistance = 40;
+		maxSizeRatio = 2;
+		maxColorDistance = 60;
+		reset();
+	}
+
+	//--------------------------------------------------------------
+
+	// forget the last frame (start of a new movie)
+
+	void reset(){
+
+		previous.clear();
+		nextId = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	// set the ids of the shapes in a frame, frames have to be tracked in order
+
+	void track(ShapeCollection & frame){
+
+		buildGrid();
+
+		int numShapes = frame.shapes.size();
+
+		frame.ids.resize(numShapes);
+
+		vector<bool> taken(previous.size(), false);
+		vector<TrackedShape> current(numShapes);
+
+		for(int i=0; i<numShapes; i++){
+
+			describe(frame, i, current[i]);
+
+			int match = findMatch(current[i], taken);
+
+			if( match >= 0 ){
+
+				taken[match] = true;
+				current[i].id = previous[match].id;
+
+			} else {
+
+				current[i].id = nextId++;
+			}
+
+			frame.ids[i] = current[i].id;
+		}
+
+		previous.swap(current);
+	}
+
+	//--------------------------------------------------------------
+
+	// carry on from a frame that already has ids, as if it was the last frame tracked
+	// (for movies that are tracked in pieces, see SegmentedExtraction)
+
+	void setPrevious(ShapeCollection & frame){
+
+		previous.resize(frame.shapes.size());
+
+		for(int i=0; i<previous.size(); i++){
+
+			describe(frame, i, previous[i]);
+			previous[i].id = frame.ids[i];
+
+			nextId = MAX(nextId, previous[i].id + 1);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	void describe(ShapeCollection & frame, int index, TrackedShape & shape){
+
+		ofRectangle & rect = frame.shapes[index].boundingRect;
+
+		shape.center = rect.getCenter();
+		shape.size = MAX(1, rect.width * rect.height);
+		shape.color = frame.colors[index];
+	}
+
+	//--------------------------------------------------------------
+
+	// sort the last frame's shapes into grid cells (one cell is as big as the furthest a shape can move)
+	// the shapes in a cell are stored one after another, starting at bucketStarts[bucket]
+
+	void buildGrid(){
+
+		numBuckets = 64;
+
+		while( numBuckets < previous.size() * 2 ) numBuckets *= 2;
+
+		bucketStarts.assign(numBuckets + 1, 0);
+
+		for(int i=0; i<previous.size(); i++){
+
+			bucketStarts[getBucket(previous[i].center) + 1]++;
+		}
+
+		for(int i=0; i<numBuckets; i++){
+
+			bucketStarts[i+1] += bucketStarts[i];
+		}
+
+		vector<int> fill(bucketStarts.begin(), bucketStarts.end() - 1);
+		bucketShapes.resize(previous.size());
+
+		for(int i=0; i<previous.size(); i++){
+
+			bucketShapes[fill[getBucket(previous[i].center)]++] = i;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	int getBucket(int cellX, int cellY){
+
+		unsigned int hash = (unsigned int)(cellX * 73856093) ^ (unsigned int)(cellY * 19349663);
+
+		return hash & (numBuckets - 1);
+	}
+
+	int getBucket(ofPoint & point){
+
+		return getBucket(floor(point.x / maxDistance), floor(point.y / maxDistance));
+	}
+
+	//--------------------------------------------------------------
+
+	// find the best untaken shape from the last frame, or -1 if none are close enough
+
+	int findMatch(TrackedShape & shape, vector<bool> & taken){
+
+		int cellX = floor(shape.center.x / maxDistance);
+		int cellY = floor(shape.center.y / maxDistance);
+
+		int best = -1;
+		float bestScore = FLT_MAX;
+
+		// look in the cell the shape is in & the cells around it
+		for(int y=cellY-1; y<=cellY+1; y++){
+			for(int x=cellX-1; x<=cellX+1; x++){
+
+				int bucket = getBucket(x, y);
+
+				for(int i=bucketStarts[bucket]; i<bucketStarts[bucket+1]; i++){
+
+					int candidate = bucketShapes[i];
+
+					if( taken[candidate] ) continue;
+
+					TrackedShape & other = previous[candidate];
+
+					float dist = shape.center.distance(other.center);
+					if( dist > maxDistance ) continue;
+
+					float sizeRatio = MAX(shape.size, other.size) / MIN(shape.size, other.size);
+					if( sizeRatio > maxSizeRatio ) continue;
+
+					float diffR = shape.color.r - other.color.r;
+					float diffG = shape.color.g - other.color.g;
+					float diffB = shape.color.b - other.color.b;
+					float colorDist = sqrt(diffR * diffR + diffG * diffG + diffB * diffB);
+					if( colorDist > maxColorDistance ) continue;
+
+					// closer, more similar shapes score lower
+					float score = dist / maxDistance + (sizeRatio - 1) / (maxSizeRatio - 1) + colorDist / maxColorDistance;
+
+					if( score < bestScore ){
+
+						bestScore = score;
+						best = candidate;
+					}
+				}
+			}
+		}
+
+		return best;
+	}
+
+	float maxDistance; // in pixels, also the size of a grid cell
+	float maxSizeRatio; // how much bigger one bounding box can be than the other
+	float maxColorDistance;
+
+	vector<TrackedShape> previous;
+	int nextId;
+
+	vector<int> bucketStarts;
+	vector<int> bucketShapes;
+	int numBuckets;
+};
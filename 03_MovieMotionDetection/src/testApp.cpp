@@ -12,68 +12,182 @@ void testApp::setup(){
 	
 	// load the movie (The Target by Jacob Dow)
 	// available on vimeo: https://vimeo.com/35391502
-	source.loadMovie("TheTarget.mov");
-	
-	// create a CV "map" to show the areas of matching color
-	changedPixelsMap.allocate(source.getWidth(), source.getHeight());
-	currentFrameCvRGB.allocate(source.getWidth(), source.getHeight());
-	currentFrameCv.allocate(source.getWidth(), source.getHeight());
-	previouFrameCv.allocate(source.getWidth(), source.getHeight());
+	moviePath = "TheTarget.mov";
+	source.loadMovie(moviePath);
 	
 	// create a window as big as the image
 	ofSetWindowShape(source.getWidth()*2, source.getHeight());
 	
 	// how close should the color be to the picked color
-	motionThreshold = 35;
+	extractor.threshold = 35;
+	
+	// how the matching pixels are turned into shapes
+	extractor.blurSize = 5;
+	extractor.minShapeArea = 5;
+	extractor.maxShapeArea = source.getWidth() * 2 * source.getHeight() / 25;
+	extractor.maxShapes = 20000;
+	
+	// only look at part of the frame, if region.xml says so (see FrameRegion)
+	// & leave out the black bars if the movie is letterboxed
+	ofxXmlSettings regionXml;
+	
+	if( regionXml.loadFile("region.xml") ) extractor.region.loadSettings(regionXml);
+	if( extractor.region.bFindBars ) extractor.region.findBars(source);
+	
+	// create a "map" to find the areas of motion, & textures to preview it
+	// tracking can go through many frames between draws, so the map has no texture of its own,
+	// the latest map (& movie frame) is only uploaded into the preview textures when it's drawn
+	// (the map is only as big as the region)
+	extractor.setup(source.getWidth(), source.getHeight(), false);
+	previewFrame.allocate(source.getWidth(), source.getHeight(), GL_RGB);
+	previewMap.allocate(extractor.region.width, extractor.region.height, GL_LUMINANCE);
+	
+	// track a piece of the movie on each core at once
+	// (set to 1 to watch the shapes being found frame by frame)
+	numSegments = getNumCores();
+	
+	// how long (in milliseconds) to spend tracking frames in each update when they're tracked here
+	trackingBudget = 25;
+	
+	// how much memory the frames' shapes can use, the rest are read back from the cache when they're used
+	// playing a finished movie streams its frames from the cache, reading a few frames ahead,
+	// so it only needs enough memory for a few frames
+	frameMemoryBudget = 1024 * 1024 * 1024;
+	playbackMemoryBudget = 16 * 1024 * 1024;
+	frames.setMemoryBudget(frameMemoryBudget);
+	frames.setLookahead(8);
 	
 	// current frame
 	currentFrame = 0;
+	numRepeatedFrames = 0;
 	
 	// we haven't saved our data yet
 	bDataExtracted = false;
 	
+	// seed the random numbers so every run tracks & splatters the same way
+	// change the seed to get a different (but still repeatable) animation
+	renderSeed = 1;
+	ofSeedRandom(renderSeed);
+	
+	// how much bigger than the movie a print of the painting is
+	printScale = 8;
+	
 	// create a canvas texture to accumulate paint shapes
 	canvas.allocate(source.getWidth(), source.getHeight(), GL_RGB);
+	clearCanvas();
+	
+	// and one to draw the keyframes in, away from the one on screen
+	keyframeCanvas.allocate(source.getWidth(), source.getHeight(), GL_RGB);
+	bBuildingKeyframes = false;
+	
+	// if this movie has already been tracked with the same settings, skip straight to playback
+	// the cache key is a hash of the movie file & every setting that changes the shapes
+	// (the movie is only hashed once, a sweep adds different settings to the same start)
+	movieCache.reset();
+	movieCache.addFile(moviePath);
+	
+	extractionCache = movieCache;
+	extractor.addToKey(extractionCache, extractor.threshold, extractor.blurSize, renderSeed);
+	
+	// keep canvas snapshots for seeking, in up to 64 MB of memory
+	// (set up now so the frames can be played while they're still being tracked)
+	keyframes.setup(source.getTotalNumFrames() - 1, 64 * 1024 * 1024);
+	
+	if( extractionCache.load(frames) ){
+		
+		ofLogNotice("Loaded " + ofToString(frames.size()) + " frames of shapes from " + extractionCache.getPath());
+		bDataExtracted = true;
+		startKeyframes();
+		
+		startPlayback();
+		
+	} else {
+		
+		// otherwise track it, writing the shapes into the cache as they're found
+		// (if the cache can't be written, every frame is kept in memory)
+		if( !extractionCache.beginSave(frames) ) ofLog(OF_LOG_WARNING, "Failed to create " + extractionCache.getPath() + ".tmp");
+		
+		// split the movie into pieces & track them all at once
+		// (if the movie can't be opened again, track it here a frame at a time)
+		// the pieces wait for their turn in part files next to the cache entry
+		if( numSegments > 1 ) segmentedExtraction.start(moviePath, source.getTotalNumFrames(), numSegments, extractor, renderSeed, extractionCache.folder + "/" + extractionCache.getKey());
+	}
 }
 
 //--------------------------------------------------------------
 
 void testApp::update(){
 
-	if( appMode == APP_MODE_TRACKING ){
+	// the pieces of the movie are tracked on their own threads
+	// pick up the frames they've finished, in order, whatever we're doing (we might be playing them already)
+	if( segmentedExtraction.isRunning() && segmentedExtraction.takeFrames(frames) ){
 		
-		// set movie to current frame (one frame at a time)
-		source.setFrame(currentFrame);
-		source.update();
-		
-		// set the prev frame to the current frame
-		previouFrameCv = currentFrameCv;
+		numRepeatedFrames = segmentedExtraction.getNumRepeatedFrames();
+		segmentedExtraction.clear();
 		
-		// get the current frame from the movie and convert to grayscale cvImage
-		currentFrameCvRGB.setFromPixels(source.getPixels(), source.getWidth(), source.getHeight());
-		currentFrameCv = currentFrameCvRGB;
-		
-		if( currentFrame > 0 ){
+		finishTracking();
+	}
+	
+	// take the keyframes a few frames at a time, whatever we're doing
+	// (rendering goes through every frame anyway, so it takes them itself)
+	if( bBuildingKeyframes && appMode != APP_MODE_RENDERING ) buildKeyframes();
+	
+	if( appMode == APP_MODE_TRACKING && !segmentedExtraction.isRunning() ){
 		
-			// search for motion and create vector shapes
-			searchForMotion(currentFrameCv, previouFrameCv, motionThreshold);
-			convertToVectors(changedPixelsMap);
-		}
+		// track as many frames as fit into this update, then draw the last one
+		// (one frame only takes a few milliseconds, tracking one per update would wait on the frame rate)
+		unsigned long startTime = ofGetElapsedTimeMillis();
 		
-		currentFrame++;
+		// the frames only need to be uploaded when they're drawn (see drawPreview)
+		source.setUseTexture(false);
 		
-		// do this until we're at the last frame of the movie
-		if( currentFrame == source.getTotalNumFrames() ){
+		while( appMode == APP_MODE_TRACKING && ofGetElapsedTimeMillis() - startTime < trackingBudget ){
 			
-			ofLogNotice("Finished tracking colors in movie");
-			appMode = APP_MODE_IDLE;
-			bDataExtracted = true;
+			// set movie to current frame
+			source.setFrame(currentFrame);
+			source.update();
+			
+			// the current frame becomes the previous frame, & the movie's frame becomes the current frame
+			extractor.setFrame(source.getPixelsRef());
+			
+			bool bRepeated = isRepeatedFrame(source.getPixelsRef());
+			
+			if( currentFrame > 0 && bRepeated ){
+				
+				// nothing has moved since the last frame, so there are no shapes
+				ShapeCollection stillFrame;
+				stillFrame.bRepeated = true;
+				tracker.track(stillFrame);
+				frames.push_back(stillFrame);
+				
+				numRepeatedFrames++;
+				
+			} else if( currentFrame > 0 ){
+			
+				// search for motion and create vector shapes
+				convertToVectors(source.getPixelsRef());
+			}
+			
+			currentFrame++;
+			
+			// do this until we're at the last frame of the movie
+			if( currentFrame == source.getTotalNumFrames() ) finishTracking();
 		}
 		
+		source.setUseTexture(true);
+		
 	} else if( appMode == APP_MODE_PLAYING ){
 		
 		// update the video
 		source.update();
+		
+		// if we've caught up with the tracking, wait for it
+		if( !bDataExtracted ){
+			
+			bool bCaughtUp = source.getCurrentFrame() >= (int)frames.size() - 1;
+			
+			if( bCaughtUp != source.isPaused() ) source.setPaused(bCaughtUp);
+		}
 	
 	} else if( appMode == APP_MODE_SAVING ){
 		
@@ -94,6 +208,113 @@ void testApp::update(){
 			ofLogNotice("Finished saving shape data to disk");
 			appMode = APP_MODE_IDLE;
 		}
+		
+	} else if( appMode == APP_MODE_RENDERING ){
+		
+		// render as many frames as we can fit into this update
+		// but don't get too far ahead of the threads that are saving the images
+		unsigned long startTime = ofGetElapsedTimeMillis();
+		
+		while( currentFrame < frames.size() && imageWriter.getNumQueued() < 16 && ofGetElapsedTimeMillis() - startTime < 30 ){
+			
+			// splatter the frame's shapes into the canvas texture
+			updateCanvas(currentFrame);
+			
+			// copy the canvas and hand it off to be saved
+			ofPixels canvasPixels;
+			canvas.readToPixels(canvasPixels);
+			
+			char fileName[30];
+			sprintf(fileName, "render/render_%.5i.png", currentFrame);
+			imageWriter.addImage(canvasPixels, fileName);
+			
+			currentFrame++;
+		}
+		
+		// wait until every image has been saved
+		if( currentFrame >= frames.size() && imageWriter.isIdle() ){
+			
+			// the saving threads aren't needed until the next render
+			imageWriter.stop();
+			
+			ofLogNotice("Finished rendering animation to disk");
+			appMode = APP_MODE_IDLE;
+			ofSetFrameRate(30);
+		}
+		
+	} else if( appMode == APP_MODE_PRINTING ){
+		
+		// draw as many frames into the print canvas as we can fit into this update
+		unsigned long startTime = ofGetElapsedTimeMillis();
+		
+		while( currentFrame < frames.size() && ofGetElapsedTimeMillis() - startTime < 30 ){
+			
+			// get the splattered shapes & draw them into the tiles
+			vector< vector<ofPoint> > outlines;
+			frames[currentFrame].getSplatterOutlines(renderSeed + currentFrame, outlines);
+			printCanvas.drawShapes(outlines, frames[currentFrame].colors, printScale);
+			
+			currentFrame++;
+		}
+		
+		// once all of the frames are drawn, save the painting
+		if( currentFrame >= frames.size() ){
+			
+			bool bSaved = printCanvas.saveAsPPM("print/print.ppm");
+			printCanvas.close();
+			
+			if( bSaved ) ofLogNotice("Finished rendering print to disk");
+			appMode = APP_MODE_IDLE;
+		}
+		
+	} else if( appMode == APP_MODE_SWEEPING ){
+		
+		// set movie to current frame (it's only uploaded when it's drawn)
+		source.setUseTexture(false);
+		source.setFrame(currentFrame);
+		source.update();
+		source.setUseTexture(true);
+		
+		extractor.setFrame(source.getPixelsRef());
+		
+		bool bRepeated = isRepeatedFrame(source.getPixelsRef());
+		
+		if( currentFrame > 0 && bRepeated ){
+			
+			// nothing has moved, so no setting finds any shapes
+			for(int i=0; i<sweep.settings.size(); i++){
+				
+				ShapeCollection stillFrame;
+				stillFrame.bRepeated = true;
+				sweep.addFrame(i, stillFrame);
+			}
+			
+		} else if( currentFrame > 0 ){
+			
+			// the difference only depends on the frames, so find it once
+			extractor.findFrameDifference();
+			
+			// then extract & save the shapes for every setting
+			for(int i=0; i<sweep.settings.size(); i++){
+				
+				extractor.thresholdFrameDifference(sweep.settings[i].threshold, sweep.settings[i].blurSize);
+				
+				ShapeCollection frameShapes;
+				extractor.extractShapes(source.getPixelsRef(), frameShapes, renderSeed + currentFrame);
+				sweep.addFrame(i, frameShapes);
+			}
+		}
+		
+		currentFrame++;
+		
+		if( currentFrame == source.getTotalNumFrames() ){
+			
+			sweep.end();
+			
+			ofLogNotice("Finished sweeping " + ofToString(sweep.settings.size()) + " settings");
+			appMode = APP_MODE_IDLE;
+			ofSetFrameRate(30);
+		}
 	}
 }
 
@@ -114,26 +335,40 @@ void testApp::draw(){
 			// playback instructions
 			ofDrawBitmapString("Press RETURN to play animation", 20, 20);
 			ofDrawBitmapString("There 's' to save animation data ", 20, 40);
+			ofDrawBitmapString("Press 'r' to render animation to images", 20, 60);
+			ofDrawBitmapString("Press 'p' to render a print-size painting", 20, 80);
+			ofDrawBitmapString("Press 'w' to sweep thresholds (from sweep.xml)", 20, 100);
 		}
 		
-	} else if ( appMode == APP_MODE_TRACKING ){
-	
+	} else if ( appMode == APP_MODE_TRACKING && segmentedExtraction.isRunning() ){
+		
 		// draw our source image
 		ofSetColor(255, 255, 255);
 		source.draw(0, 0);
 		
-		// draw the changed pixels map
+		// info about tracking
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Tracking "+ofToString(segmentedExtraction.getNumFramesDone())+"/"+ofToString(source.getTotalNumFrames() - 1)+" frames", ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("In "+ofToString(segmentedExtraction.segments.size())+" pieces at once", ofGetWidth()/2+20, 40);
+		ofDrawBitmapString(ofToString(segmentedExtraction.getNumRepeatedFrames())+" frames were repeats of the frame before", ofGetWidth()/2+20, 60);
+		
+		if( frames.size() > 0 ) ofDrawBitmapString("Press RETURN to play what's been tracked so far", ofGetWidth()/2+20, 80);
+		
+	} else if ( appMode == APP_MODE_TRACKING ){
+	
+		// draw the frame we're on & its map
 		// the white pixels indicate matching colors
 		ofSetColor(255, 255, 255);
-		changedPixelsMap.draw(ofGetWidth()/2, 0);
+		drawPreview();
 		
 		// draw the blobs found in the open cv search
-		contourFinder.draw(ofGetWidth()/2, 0);
+		extractor.contourFinder.draw(ofGetWidth()/2 + extractor.region.x, extractor.region.y);
 		
 		// info about tracking
 		ofSetColor(0, 255, 255);
 		ofDrawBitmapString("Tracking frame "+ofToString(currentFrame)+"/"+ofToString(source.getTotalNumFrames()), ofGetWidth()/2+20, 20);
-		ofDrawBitmapString("There are "+ofToString(contourFinder.nBlobs)+" shapes", ofGetWidth()/2+20, 40);
+		ofDrawBitmapString("There are "+ofToString(extractor.contourFinder.nBlobs)+" shapes", ofGetWidth()/2+20, 40);
+		ofDrawBitmapString(ofToString(numRepeatedFrames)+" frames were repeats of the frame before", ofGetWidth()/2+20, 60);
 		
 	} else if(appMode == APP_MODE_PLAYING) {
 	
@@ -142,29 +377,45 @@ void testApp::draw(){
 		
 		if( source.isFrameNew() ){
 		
-			int currentFrame = source.getCurrentFrame();
-
-			// draw into the canvas texture
-			canvas.begin();
-			
-			if( currentFrame < frames.size()) {
-			
-				// draw the shapes in splatter form
-				frames[currentFrame].drawSplatter();
-			}
-			
-			canvas.end();
-			
+			// draw the shapes in splatter form into the canvas texture
+			updateCanvas(source.getCurrentFrame());
 		}
 		
 		// then draw the canvas texture
 		ofSetColor(255, 255, 255);
 		canvas.draw(ofGetWidth()/2, 0);
 		
+		ofSetColor(0, 255, 255);
+		string keyframeInfo = ofToString(keyframes.getNumKeyframes())+" keyframes, every "+ofToString(keyframes.getInterval())+" frames";
+		if( bBuildingKeyframes ) keyframeInfo += " (taking them, "+ofToString(keyframeFrame + 1)+"/"+ofToString(frames.size())+")";
+		ofDrawBitmapString(keyframeInfo, ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("LEFT/RIGHT or drag across the movie to seek", ofGetWidth()/2+20, 40);
+		
+		// how detailed the shapes drawn the last time the canvas was updated were (level 0 is the full outline)
+		string levelInfo = "Shapes drawn at each level of detail:";
+		
+		for(int i=0; i<levelCounts.size(); i++){
+			
+			levelInfo += " " + ofToString(levelCounts[i]);
+		}
+		
+		ofDrawBitmapString(levelInfo, ofGetWidth()/2+20, 60);
+		
+		// still tracking the rest of the movie
+		if( segmentedExtraction.isRunning() ){
+			
+			ofDrawBitmapString("Tracked "+ofToString(frames.size())+"/"+ofToString(source.getTotalNumFrames() - 1)+" frames so far", ofGetWidth()/2+20, 80);
+			
+			if( source.isPaused() ) ofDrawBitmapString("Waiting for the tracking to catch up", ofGetWidth()/2+20, 100);
+		}
+		
 		if( source.getPosition() == 1.0 ){
 			
 			ofDrawBitmapString("Press RETURN to play animation", 20, 20);
 			ofDrawBitmapString("There 's' to save animation data ", 20, 40);
+			ofDrawBitmapString("Press 'r' to render animation to images", 20, 60);
+			ofDrawBitmapString("Press 'p' to render a print-size painting", 20, 80);
+			ofDrawBitmapString("Press 'w' to sweep thresholds (from sweep.xml)", 20, 100);
 		}
 
 	} else if(appMode == APP_MODE_SAVING) {
@@ -183,6 +434,34 @@ void testApp::draw(){
 		
 		ofSetColor(0, 255, 255);
 		ofDrawBitmapString("Saving frame "+ofToString(currentFrame)+"/"+ofToString(source.getTotalNumFrames()), ofGetWidth()/2+20, 20);
+		
+	} else if(appMode == APP_MODE_RENDERING) {
+		
+		// show the canvas as it's being rendered
+		ofSetColor(255, 255, 255);
+		canvas.draw(ofGetWidth()/2, 0);
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Rendering frame "+ofToString(currentFrame)+"/"+ofToString(frames.size()), ofGetWidth()/2+20, 20);
+		
+	} else if(appMode == APP_MODE_PRINTING) {
+		
+		ofSetColor(255, 255, 255);
+		source.draw(0, 0);
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Printing frame "+ofToString(currentFrame)+"/"+ofToString(frames.size()), ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("Print size "+ofToString(printCanvas.width)+" x "+ofToString(printCanvas.height), ofGetWidth()/2+20, 40);
+		
+	} else if(appMode == APP_MODE_SWEEPING) {
+		
+		// show the source & the map for the last setting
+		ofSetColor(255, 255, 255);
+		drawPreview();
+		
+		ofSetColor(0, 255, 255);
+		ofDrawBitmapString("Sweeping frame "+ofToString(currentFrame)+"/"+ofToString(source.getTotalNumFrames()), ofGetWidth()/2+20, 20);
+		ofDrawBitmapString("Trying "+ofToString(sweep.settings.size())+" settings", ofGetWidth()/2+20, 40);
 	}
 }
 
@@ -213,133 +492,298 @@ ofColor testApp::getColorAtPos(ofPixels & pixels, int x, int y){
 
 //--------------------------------------------------------------
 
-// get all of similar colors in an image
+// find the shapes of the motion & convert them to vectors
 
-void testApp::searchForMotion(ofxCvGrayscaleImage & curFrame, ofxCvGrayscaleImage & prevFrame, int thresh){
-	
-	changedPixelsMap = curFrame;
-	
-	changedPixelsMap.absDiff(prevFrame);
+void testApp::convertToVectors(ofPixels & pixels){
 	
-	changedPixelsMap.threshold(thresh, false);
+	// (the colors of the shapes are sampled randomly, seeding with the frame means a sweep gets the same shapes)
+	ShapeCollection frameShapes;
+	extractor.extract(pixels, frameShapes, renderSeed + currentFrame);
 	
-	changedPixelsMap.blur(5);
+	// link the shapes to the ones in the last frame
+	tracker.track(frameShapes);
 	
-	changedPixelsMap.threshold(128);
+	frames.push_back(frameShapes);
 }
 
 //--------------------------------------------------------------
 
-// use opencv's contour finder to get the outlines from a greyscale image
+// once the frames are all tracked (or loaded) go through them once, in order, drawing them into
+// a canvas of their own & taking every keyframe, so seeking anywhere only replays from the closest one
+// the frames are read from the cache by a reader of their own so the frames being played aren't
+// pushed out of memory (if there's no cache they're all in memory anyway)
 
-void testApp::convertToVectors(ofxCvGrayscaleImage & map){
-
-	contourFinder.findContours(map, 5, ofGetWidth() * ofGetHeight() / 25, 20000, true, false);
+void testApp::startKeyframes(){
 	
-	ShapeCollection frameShapes;
+	keyframeReader.open(extractionCache.getPath());
+	
+	keyframeCanvas.begin();
+	ofClear(238, 234, 213);
+	keyframeCanvas.end();
+	
+	keyframeFrame = -1;
+	bBuildingKeyframes = true;
+}
+
+//--------------------------------------------------------------
+
+void testApp::buildKeyframes(){
 	
-	int numShapes = contourFinder.nBlobs;
+	unsigned long startTime = ofGetElapsedTimeMillis();
 	
-	for(int i=0; i<numShapes; i++){
+	while( keyframeFrame < (int)frames.size() - 1 && ofGetElapsedTimeMillis() - startTime < 10 ){
+		
+		keyframeFrame++;
 		
-		// create a new blob
-		// copy over the blob data from the source blob
-		ofxCvBlob newBlob;
-		newBlob.nPts = contourFinder.blobs[i].nPts;
-		newBlob.pts.insert(newBlob.pts.begin(), contourFinder.blobs[i].pts.begin(), contourFinder.blobs[i].pts.end());
-		newBlob.boundingRect = contourFinder.blobs[i].boundingRect;
-		frameShapes.addShape(newBlob);
+		keyframeCanvas.begin();
 		
-		ofColor shapeColor = getColorOfShape(contourFinder.blobs[i]);
-		frameShapes.addColor(shapeColor);
+		if( keyframeReader.isOpen() ){
+			
+			ShapeCollection frame;
+			keyframeReader.getFrame(keyframeFrame, frame);
+			frame.drawSplatter(renderSeed + keyframeFrame);
+			
+		} else {
+			
+			frames[keyframeFrame].drawSplatter(renderSeed + keyframeFrame);
+		}
+		
+		keyframeCanvas.end();
+		
+		if( keyframes.isKeyframe(keyframeFrame) ){
+			
+			keyframes.addKeyframe(keyframeFrame, keyframeCanvas);
+		}
+	}
+	
+	if( keyframeFrame == (int)frames.size() - 1 ){
+		
+		keyframeReader.close();
+		bBuildingKeyframes = false;
 	}
+}
+
+//--------------------------------------------------------------
+
+void testApp::finishTracking(){
 	
-	//printf("we have %i shapes\n", frameShapes.shapes.size());
+	ofLogNotice("Finished tracking colors in movie");
+	bDataExtracted = true;
 	
-	frames.push_back(frameShapes);
+	// if we were playing the frames as they came in, carry on
+	if( appMode == APP_MODE_TRACKING ) appMode = APP_MODE_IDLE;
+	else if( appMode == APP_MODE_PLAYING ) source.setPaused(false);
+	
+	// remember the shapes so the next run can skip tracking
+	// (they've been written into the cache as they were tracked, this finishes the entry)
+	if( !extractionCache.endSave(frames) ) ofLog(OF_LOG_WARNING, "Failed to save shapes to " + extractionCache.getPath());
+	
+	// now every frame is known, take all of the keyframes
+	startKeyframes();
 }
 
 //--------------------------------------------------------------
 
-// this is one of many ways to grab the color from a blob
-// it's actually a very fast and not-so accurate way to do so 
-// we're grabbing 5 random colors and averaging them
-// but we need make sure that the randomly selected colors are from those 
-// pixels that has changed since the last frame (which are the white pixels 
-// saved in the cvImage changedPixelsMap)
+// is a frame the same as the one before it? (held titles, freeze frames, telecine)
+// motion is always between neighbouring frames, so each frame is compared with the one just before
 
-ofColor testApp::getColorOfShape(ofxCvBlob & shape){
+bool testApp::isRepeatedFrame(ofPixels & pixels){
+	
+	frameFingerprint.set(pixels);
 	
-	ofColor results;
-	ofRectangle searchRect = shape.boundingRect;
+	bool bRepeated = frameFingerprint.matches(lastFingerprint);
 	
-	unsigned char * mapPix = changedPixelsMap.getPixels();
-	unsigned char * pix = source.getPixels();
+	lastFingerprint.swap(frameFingerprint);
+	
+	return bRepeated;
+}
+
+//--------------------------------------------------------------
+
+// show the latest movie frame & map that were tracked, side by side
+// they're uploaded here, once per draw, rather than every time a frame is tracked
+
+void testApp::drawPreview(){
 	
-	int sumR = 0;
-	int sumG = 0;
-	int sumB = 0;
+	previewFrame.loadData(source.getPixels(), source.getWidth(), source.getHeight(), GL_RGB);
+	previewFrame.draw(0, 0);
 	
-	int pixFound = 0;
+	previewMap.loadData(extractor.changedPixelsMap.getPixels(), extractor.changedPixelsMap.getWidth(), extractor.changedPixelsMap.getHeight(), GL_LUMINANCE);
+	previewMap.draw(ofGetWidth()/2 + extractor.region.x, extractor.region.y);
+}
+
+//--------------------------------------------------------------
+
+// fill the canvas with the paper color
+
+void testApp::clearCanvas(){
 	
-	while( pixFound < 5 ){
+	canvas.begin();
+	ofClear(238, 234, 213);
+	canvas.end();
 	
-		// randomly look in the blob area for a white color
-		int randX = searchRect.x + ofRandom(searchRect.width);
-		int randY = searchRect.y + ofRandom(searchRect.height);
-		int memPos = randY * source.getWidth() + randX;
+	canvasFrame = -1;
+}
+
+//--------------------------------------------------------------
+
+// bring the canvas up to date with a frame of the animation
+// the canvas accumulates shapes, so it depends on every frame before this one
+// when we jump around, start from the closest keyframe & replay the frames after it
+// (until buildKeyframes has been through every frame, jumping past the last keyframe
+// still has to replay everything since it)
+
+void testApp::updateCanvas(int frame){
+	
+	frame = MIN(frame, (int)frames.size() - 1);
+	
+	if( frame == canvasFrame ) return;
+	
+	levelCounts.assign(ShapeCollection::numLevels, 0);
+	
+	// going backwards, or far enough ahead that a keyframe is closer
+	if( frame < canvasFrame || frame - canvasFrame > keyframes.getInterval() ){
+		
+		int keyframe = keyframes.getKeyframeBefore(frame);
+		
+		if( keyframe >= 0 && (keyframe > canvasFrame || frame < canvasFrame) ){
+			
+			keyframes.restoreKeyframe(keyframe, canvas);
+			canvasFrame = keyframe;
+			
+		} else if( frame < canvasFrame ){
+			
+			// no keyframe to go back to, start from scratch
+			clearCanvas();
+		}
+	}
+	
+	// replay the frames in between, taking snapshots along the way
+	while( canvasFrame < frame ){
 		
-		// if the pixel is white
-		if( mapPix[memPos] == 255 ){
+		canvasFrame++;
 		
-			// mult by 3 (because it's a color source)
-			memPos = memPos * 3;
+		canvas.begin();
+		frames[canvasFrame].drawSplatter(renderSeed + canvasFrame, 1.0, &levelCounts);
+		canvas.end();
 		
-			// get the RGB values
-			sumR += pix[memPos];
-			sumG += pix[memPos+1];
-			sumB += pix[memPos+2];
+		if( keyframes.isKeyframe(canvasFrame) ){
 			
-			pixFound++;
+			keyframes.addKeyframe(canvasFrame, canvas);
 		}
 	}
+}
+
+//--------------------------------------------------------------
+
+void testApp::startPlayback(){
+	
+	// start play mode (at the first frame)
+	appMode = APP_MODE_PLAYING;
+	currentFrame = 0;
+	
+	// stream the frames if they're all in the cache
+	frames.setMemoryBudget( bDataExtracted ? playbackMemoryBudget : frameMemoryBudget );
+	
+	// clear the canvas, the keyframes we've stored stay around for seeking
+	clearCanvas();
+	
+	// start the movie
+	source.setPosition(0.0);
+	source.play();
+	source.setLoopState(OF_LOOP_NONE);
+}
+
+//--------------------------------------------------------------
+
+// jump to a frame in the movie & the animation
+
+void testApp::seekToFrame(int frame){
 	
-	// update the color with the average values
-	results.r = sumR/pixFound;
-	results.g = sumG/pixFound;
-	results.b = sumB/pixFound;
+	frame = ofClamp(frame, 0, frames.size() - 1);
 	
-	return results;
+	source.setFrame(frame);
+	updateCanvas(frame);
 }
- 
+
 //--------------------------------------------------------------
 
 void testApp::keyPressed(int key){
 	
+	// the frames that have been tracked can be played while the rest are still being tracked
+	if( key == OF_KEY_RETURN && !bDataExtracted && segmentedExtraction.isRunning() && frames.size() > 0 ){
+		
+		startPlayback();
+		return;
+	}
+	
 	// don't do anything unless we've extracted all of our movement data
 	if( bDataExtracted ){
 	
 		if( key == OF_KEY_RETURN ){
 	
-			// start play mode (at the first frame)
-			appMode = APP_MODE_PLAYING;
-			currentFrame = 0;
-			
-			// clear the canvas/fbo with a specific color
-			canvas.begin();
-			ofClear(238, 234, 213);
-			canvas.end();
-			
-			// start the movie
-			source.setPosition(0.0);
-			source.play();
-			source.setLoopState(OF_LOOP_NONE);
+			startPlayback();
 	
 		} else if( key == 's' ){
 
 			// start save mode
 			appMode = APP_MODE_SAVING;
 			currentFrame = 0;
+		
+		} else if( appMode == APP_MODE_PLAYING && (key == OF_KEY_LEFT || key == OF_KEY_RIGHT) ){
+			
+			// skip back or ahead one second
+			int offset = ( key == OF_KEY_LEFT ) ? -30 : 30;
+			seekToFrame(source.getCurrentFrame() + offset);
+		
+		} else if( key == 'r' ){
+			
+			// start render mode
+			// draw every frame into the canvas & save it as an image, as fast as we can
+			appMode = APP_MODE_RENDERING;
+			currentFrame = 0;
+			ofSetFrameRate(0);
+			
+			clearCanvas();
+			
+			ofDirectory::createDirectory("render");
+			imageWriter.start();
+		
+		} else if( key == 'p' ){
+			
+			// start print mode
+			// draw the whole animation into one very large canvas that's stored on disk
+			ofDirectory::createDirectory("print");
+			
+			if( printCanvas.setup(source.getWidth() * printScale, source.getHeight() * printScale, "print/canvas.tiles", ofColor(238, 234, 213)) ){
+				
+				appMode = APP_MODE_PRINTING;
+				currentFrame = 0;
+				
+			} else {
+				
+				ofLog(OF_LOG_ERROR, "Failed to create the print canvas");
+			}
+		
+		} else if( key == 'w' ){
+			
+			// start sweep mode
+			// track the movie again with every setting in sweep.xml, decoding each frame once
+			sweep.setup("sweep.xml", extractor.threshold, extractor.blurSize);
+			
+			for(int i=0; i<sweep.settings.size(); i++){
+				
+				sweep.settings[i].cache = movieCache;
+				extractor.addToKey(sweep.settings[i].cache, sweep.settings[i].threshold, sweep.settings[i].blurSize, renderSeed);
+			}
+			
+			if( sweep.begin() ){
+				
+				appMode = APP_MODE_SWEEPING;
+				currentFrame = 0;
+				lastFingerprint.clear();
+				ofSetFrameRate(0);
+			}
 		}
 	}
 }
@@ -360,6 +804,11 @@ void testApp::mouseMoved(int x, int y){
 
 void testApp::mouseDragged(int x, int y, int button){
 
+	// scrub thru the animation by dragging across the movie
+	if( appMode == APP_MODE_PLAYING && x < ofGetWidth()/2 ){
+		
+		seekToFrame( (float)x / (ofGetWidth()/2) * frames.size() );
+	}
 }
 
 //--------------------------------------------------------------
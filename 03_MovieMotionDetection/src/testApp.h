@@ -13,8 +13,18 @@ September 2012
 #include "ofxXmlSettings.h"
 #include "ofxOpenCv.h"
 #include "ShapeCollection.h"
+#include "ImageSequenceWriter.h"
+#include "CanvasKeyframes.h"
+#include "TiledCanvas.h"
+#include "FrameStore.h"
+#include "ExtractionCache.h"
+#include "ExtractionSweep.h"
+#include "ShapeTracker.h"
+#include "ShapeExtractor.h"
+#include "SegmentedExtraction.h"
+#include "FrameFingerprint.h"
 
-enum { APP_MODE_IDLE = 0, APP_MODE_TRACKING, APP_MODE_PLAYING, APP_MODE_SAVING };
+enum { APP_MODE_IDLE = 0, APP_MODE_TRACKING, APP_MODE_PLAYING, APP_MODE_SAVING, APP_MODE_RENDERING, APP_MODE_PRINTING, APP_MODE_SWEEPING };
 
 class testApp : public ofBaseApp{
 	
@@ -25,9 +35,17 @@ public:
 	void draw();
 	
 	ofColor getColorAtPos(ofPixels & pixels, int x, int y);
-	void searchForMotion(ofxCvGrayscaleImage & curFrame, ofxCvGrayscaleImage & prevFrame, int thresh);
-	void convertToVectors(ofxCvGrayscaleImage & map);
-	ofColor getColorOfShape(ofxCvBlob & shape);
+	void convertToVectors(ofPixels & pixels);
+	bool isRepeatedFrame(ofPixels & pixels);
+	void finishTracking();
+	
+	void drawPreview();
+	void clearCanvas();
+	void updateCanvas(int frame);
+	void startKeyframes();
+	void buildKeyframes();
+	void seekToFrame(int frame);
+	void startPlayback();
 	
 	void keyPressed(int key);
 	void keyReleased(int key);
@@ -37,16 +55,39 @@ public:
 	void mouseReleased(int x, int y, int button);
 	
 	ofVideoPlayer source;
-	int motionThreshold;
+	ShapeExtractor extractor;
+	ofTexture previewFrame;
+	ofTexture previewMap;
 	int currentFrame;
 	int appMode;
 	bool bDataExtracted;
+	int renderSeed;
 	
-	ofxCvColorImage currentFrameCvRGB;
-	ofxCvGrayscaleImage currentFrameCv;
-	ofxCvGrayscaleImage previouFrameCv;
-	ofxCvGrayscaleImage changedPixelsMap;
-	ofxCvContourFinder 	contourFinder;
-	vector <ShapeCollection> frames;
+	FrameStore frames;
+	uint64_t frameMemoryBudget;
+	uint64_t playbackMemoryBudget;
 	ofFbo canvas;
+	int canvasFrame;
+	vector<int> levelCounts; // how many shapes were drawn at each level of detail (see updateCanvas)
+	CanvasKeyframes keyframes;
+	ofFbo keyframeCanvas; // every frame is drawn in here once to take the keyframes (see buildKeyframes)
+	ShapeSequenceReader keyframeReader;
+	int keyframeFrame;
+	bool bBuildingKeyframes;
+	TiledCanvas printCanvas;
+	float printScale;
+	ImageSequenceWriter imageWriter;
+	
+	string moviePath;
+	ExtractionCache movieCache;
+	ExtractionCache extractionCache;
+	ExtractionSweep sweep;
+	ShapeTracker tracker;
+	SegmentedExtraction segmentedExtraction;
+	int numSegments;
+	int trackingBudget;
+	
+	FrameFingerprint frameFingerprint;
+	FrameFingerprint lastFingerprint;
+	int numRepeatedFrames;
 };
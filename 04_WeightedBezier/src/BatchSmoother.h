@@ -0,0 +1,190 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "Poco/Environment.h"
+#include "BezierShape.h"
+#include "BezierSmoother.h"
+#include "CurveFitter.h"
+
+// smooths every shape in every frame of a sequence saved by the tracking apps
+// (a folder of frame_00000.xml, frame_00001.xml, ...)
+// the frames are shared out between a pool of threads, one per processor core
+// the smoothed shapes are saved with the same file names into the output folder
+// shapes are either smoothed thru their points or fit with as few curves as possible
+
+class BatchSmoother {
+
+public:
+
+	//--------------------------------------------------------------
+
+	// one worker in the pool
+	// it keeps taking the next unprocessed frame until there are none left
+
+	class Worker : public ofThread {
+
+	public:
+
+		BatchSmoother * batch;
+		BezierSmoother smoother;
+		CurveFitter fitter;
+
+		void threadedFunction(){
+
+			int index;
+
+			while( isThreadRunning() && batch->getNextFile(index) ){
+
+				batch->processFile(index, smoother, fitter);
+			}
+		}
+	};
+
+	//--------------------------------------------------------------
+
+	BatchSmoother(){
+
+		nextFile = 0;
+		numFinished = 0;
+		bFitCurves = false;
+	}
+
+	~BatchSmoother(){
+
+		stop();
+	}
+
+	//--------------------------------------------------------------
+
+	// start smoothing all of the xml files in a folder
+
+	void start(string inputFolder, string outputFolder, bool fitCurves = false, int numThreads = 0){
+
+		stop();
+
+		ofDirectory dir;
+		dir.allowExt("xml");
+		dir.listDir(inputFolder);
+		dir.sort();
+
+		fileNames.clear();
+
+		for(int i=0; i<dir.numFiles(); i++){
+
+			fileNames.push_back(dir.getName(i));
+		}
+
+		inputPath = inputFolder;
+		outputPath = outputFolder;
+		bFitCurves = fitCurves;
+		nextFile = 0;
+		numFinished = 0;
+
+		ofDirectory::createDirectory(outputPath);
+
+		if( numThreads <= 0 ) numThreads = Poco::Environment::processorCount();
+
+		for(int i=0; i<numThreads; i++){
+
+			Worker * worker = new Worker();
+			worker->batch = this;
+			worker->startThread(false, false);
+			workers.push_back(worker);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// stop the workers (they finish the frame they're working on)
+
+	void stop(){
+
+		for(int i=0; i<workers.size(); i++){
+
+			workers[i]->waitForThread(true);
+			delete workers[i];
+		}
+
+		workers.clear();
+	}
+
+	//--------------------------------------------------------------
+
+	int getNumFiles(){
+
+		return fileNames.size();
+	}
+
+	int getNumFinished(){
+
+		ofScopedLock lock(mutex);
+
+		return numFinished;
+	}
+
+	bool isFinished(){
+
+		return getNumFinished() == getNumFiles();
+	}
+
+	//--------------------------------------------------------------
+
+	// hand out the next frame to a worker
+
+	bool getNextFile(int & index){
+
+		ofScopedLock lock(mutex);
+
+		if( nextFile >= fileNames.size() ) return false;
+
+		index = nextFile;
+		nextFile++;
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// load all of the shapes in a frame, smooth them & save them
+
+	void processFile(int index, BezierSmoother & smoother, CurveFitter & fitter){
+
+		vector< vector<ofPoint> > outlines;
+		vector<ofColor> colors;
+
+		if( ShapeFile::loadPointShapes(inputPath + "/" + fileNames[index], outlines, colors) ){
+
+			vector<BezierShape> shapes(outlines.size());
+
+			for(int i=0; i<outlines.size(); i++){
+
+				if( bFitCurves ){
+
+					fitter.fit(outlines[i], shapes[i]);
+
+				} else {
+
+					smoother.smooth(outlines[i], shapes[i]);
+				}
+
+				shapes[i].color = colors[i];
+			}
+
+			ShapeFile::saveBezierShapes(outputPath + "/" + fileNames[index], shapes);
+		}
+
+		ofScopedLock lock(mutex);
+		numFinished++;
+	}
+
+	string inputPath;
+	string outputPath;
+	vector<string> fileNames;
+	int nextFile;
+	int numFinished;
+	bool bFitCurves;
+
+	vector<Worker*> workers;
+	ofMutex mutex;
+};
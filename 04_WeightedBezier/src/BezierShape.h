@@ -0,0 +1,342 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxXmlSettings.h"
+
+// one cubic bezier curve
+// it starts where the previous curve ended (or at the shape's start point)
+
+struct BezierSegment {
+
+	ofPoint control1;
+	ofPoint control2;
+	ofPoint end;
+};
+
+// a closed shape made out of bezier curves
+// for drawing, the curves are flattened into polylines at several levels of detail
+// level 0 is within a fraction of a pixel of the curves, each level after that is twice as coarse
+// the levels are only created when they're first drawn, then kept until the curves change
+
+class BezierShape {
+
+public:
+
+	//--------------------------------------------------------------
+
+	BezierShape(){
+
+		baseTolerance = 0.125;
+		lastLevelDrawn = 0;
+	}
+
+	//--------------------------------------------------------------
+
+	void clear(){
+
+		segments.clear();
+		levels.clear();
+	}
+
+	//--------------------------------------------------------------
+
+	void addSegment(ofPoint control1, ofPoint control2, ofPoint end){
+
+		BezierSegment segment;
+		segment.control1 = control1;
+		segment.control2 = control2;
+		segment.end = end;
+
+		segments.push_back(segment);
+		levels.clear();
+	}
+
+	//--------------------------------------------------------------
+
+	// add the curves to a path as a new subpath
+
+	void addToPath(ofPath & path){
+
+		if( segments.size() == 0 ) return;
+
+		path.moveTo(start);
+
+		for(int i=0; i<segments.size(); i++){
+
+			path.bezierTo(segments[i].control1, segments[i].control2, segments[i].end);
+		}
+
+		path.close();
+	}
+
+	//--------------------------------------------------------------
+
+	// flatten the curves into a polyline
+	// each curve is split in half until it's within the tolerance of a straight line
+
+	void flatten(float tolerance, vector<ofPoint> & points){
+
+		points.clear();
+		points.push_back(start);
+
+		ofPoint from = start;
+
+		for(int i=0; i<segments.size(); i++){
+
+			flattenCurve(from, segments[i].control1, segments[i].control2, segments[i].end, 16 * tolerance * tolerance, points, 0);
+			from = segments[i].end;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	static void flattenCurve(ofPoint p0, ofPoint p1, ofPoint p2, ofPoint p3, float limit, vector<ofPoint> & points, int depth){
+
+		// how far the control points are from being a straight line (squared, times 16)
+		float ux = 3 * p1.x - 2 * p0.x - p3.x;
+		float uy = 3 * p1.y - 2 * p0.y - p3.y;
+		float vx = 3 * p2.x - 2 * p3.x - p0.x;
+		float vy = 3 * p2.y - 2 * p3.y - p0.y;
+
+		float flatness = MAX(ux * ux, vx * vx) + MAX(uy * uy, vy * vy);
+
+		if( flatness <= limit || depth >= 16 ){
+
+			points.push_back(p3);
+			return;
+		}
+
+		// split the curve in half (de Casteljau)
+		ofPoint p01 = (p0 + p1) * 0.5;
+		ofPoint p12 = (p1 + p2) * 0.5;
+		ofPoint p23 = (p2 + p3) * 0.5;
+		ofPoint p012 = (p01 + p12) * 0.5;
+		ofPoint p123 = (p12 + p23) * 0.5;
+		ofPoint middle = (p012 + p123) * 0.5;
+
+		flattenCurve(p0, p01, p012, middle, limit, points, depth + 1);
+		flattenCurve(middle, p123, p23, p3, limit, points, depth + 1);
+	}
+
+	//--------------------------------------------------------------
+
+	// get the polyline for a level of detail (creating it if needed)
+
+	vector<ofPoint> & getLevel(int level){
+
+		if( levels.size() != numLevels ) levels.resize(numLevels);
+
+		if( levels[level].size() == 0 && segments.size() > 0 ){
+
+			flatten(baseTolerance * (1 << level), levels[level]);
+		}
+
+		return levels[level];
+	}
+
+	//--------------------------------------------------------------
+
+	// pick the coarsest level that's still within the pixel tolerance at this scale
+
+	int getLevelForScale(float scale, float pixelTolerance = 0.5){
+
+		if( scale <= 0 ) return numLevels - 1;
+
+		int level = floor(log(pixelTolerance / (baseTolerance * scale)) / log(2.0));
+
+		return ofClamp(level, 0, numLevels - 1);
+	}
+
+	//--------------------------------------------------------------
+
+	// draw the shape at a position & scale
+	// returns the number of points drawn
+
+	int draw(float x, float y, float scale = 1.0){
+
+		lastLevelDrawn = getLevelForScale(scale);
+		vector<ofPoint> & points = getLevel(lastLevelDrawn);
+
+		ofPushMatrix();
+		ofTranslate(x, y, 0);
+		ofScale(scale, scale, 1);
+
+		ofSetColor(color);
+
+		ofBeginShape();
+		ofVertexes(points);
+		ofEndShape(true);
+
+		ofPopMatrix();
+
+		return points.size();
+	}
+
+	static const int numLevels = 8;
+
+	ofColor color;
+	ofPoint start;
+	vector<BezierSegment> segments;
+
+	float baseTolerance; // in the shape's own pixels
+	vector< vector<ofPoint> > levels;
+	int lastLevelDrawn;
+};
+
+// reading & writing shape files
+
+class ShapeFile {
+
+public:
+
+	//--------------------------------------------------------------
+
+	// load every shape from a file saved by the tracking apps
+	// each shape is a list of points & a color
+
+	static bool loadPointShapes(string filePath, vector< vector<ofPoint> > & outlines, vector<ofColor> & colors){
+
+		outlines.clear();
+		colors.clear();
+
+		ofxXmlSettings xmlDoc;
+
+		if( !xmlDoc.loadFile(filePath) || !xmlDoc.tagExists("shapes") ){
+
+			ofLog(OF_LOG_ERROR, "Failed to load shape file " + filePath);
+			return false;
+		}
+
+		xmlDoc.pushTag("shapes");
+
+		int numShapes = xmlDoc.getNumTags("shape");
+
+		outlines.resize(numShapes);
+		colors.resize(numShapes);
+
+		for(int i=0; i<numShapes; i++){
+
+			xmlDoc.pushTag("shape", i);
+
+			colors[i].set(xmlDoc.getAttribute("color", "r", 0), xmlDoc.getAttribute("color", "g", 0), xmlDoc.getAttribute("color", "b", 0));
+
+			xmlDoc.pushTag("points");
+
+			int numPoints = xmlDoc.getNumTags("point");
+			outlines[i].resize(numPoints);
+
+			for(int j=0; j<numPoints; j++){
+
+				outlines[i][j].set(xmlDoc.getAttribute("point", "x", 0, j), xmlDoc.getAttribute("point", "y", 0, j));
+			}
+
+			xmlDoc.popTag();
+			xmlDoc.popTag();
+		}
+
+		xmlDoc.popTag();
+
+		return true;
+	}
+
+	//--------------------------------------------------------------
+
+	// save bezier shapes
+	// each shape has a color, a start point and a list of curves
+
+	static bool saveBezierShapes(string filePath, vector<BezierShape> & shapes){
+
+		ofxXmlSettings xmlDoc;
+
+		xmlDoc.addTag("shapes");
+		xmlDoc.pushTag("shapes");
+
+		for(int i=0; i<shapes.size(); i++){
+
+			xmlDoc.addTag("shape");
+			xmlDoc.pushTag("shape", i);
+
+			xmlDoc.addTag("color");
+			xmlDoc.addAttribute("color", "r", shapes[i].color.r, 0);
+			xmlDoc.addAttribute("color", "g", shapes[i].color.g, 0);
+			xmlDoc.addAttribute("color", "b", shapes[i].color.b, 0);
+
+			xmlDoc.addTag("curves");
+			xmlDoc.pushTag("curves");
+
+			xmlDoc.addTag("start");
+			xmlDoc.addAttribute("start", "x", shapes[i].start.x, 0);
+			xmlDoc.addAttribute("start", "y", shapes[i].start.y, 0);
+
+			for(int j=0; j<shapes[i].segments.size(); j++){
+
+				BezierSegment & segment = shapes[i].segments[j];
+
+				xmlDoc.addTag("curve");
+				xmlDoc.addAttribute("curve", "c1x", segment.control1.x, j);
+				xmlDoc.addAttribute("curve", "c1y", segment.control1.y, j);
+				xmlDoc.addAttribute("curve", "c2x", segment.control2.x, j);
+				xmlDoc.addAttribute("curve", "c2y", segment.control2.y, j);
+				xmlDoc.addAttribute("curve", "x", segment.end.x, j);
+				xmlDoc.addAttribute("curve", "y", segment.end.y, j);
+			}
+
+			xmlDoc.popTag();
+			xmlDoc.popTag();
+		}
+
+		return xmlDoc.saveFile(filePath);
+	}
+
+	//--------------------------------------------------------------
+
+	// load bezier shapes saved with saveBezierShapes()
+
+	static bool loadBezierShapes(string filePath, vector<BezierShape> & shapes){
+
+		shapes.clear();
+
+		ofxXmlSettings xmlDoc;
+
+		if( !xmlDoc.loadFile(filePath) || !xmlDoc.tagExists("shapes") ){
+
+			ofLog(OF_LOG_ERROR, "Failed to load shape file " + filePath);
+			return false;
+		}
+
+		xmlDoc.pushTag("shapes");
+
+		int numShapes = xmlDoc.getNumTags("shape");
+		shapes.resize(numShapes);
+
+		for(int i=0; i<numShapes; i++){
+
+			xmlDoc.pushTag("shape", i);
+
+			shapes[i].color.set(xmlDoc.getAttribute("color", "r", 0), xmlDoc.getAttribute("color", "g", 0), xmlDoc.getAttribute("color", "b", 0));
+
+			xmlDoc.pushTag("curves");
+
+			shapes[i].start.set(xmlDoc.getAttribute("start", "x", 0.0), xmlDoc.getAttribute("start", "y", 0.0));
+
+			int numCurves = xmlDoc.getNumTags("curve");
+
+			for(int j=0; j<numCurves; j++){
+
+				ofPoint control1(xmlDoc.getAttribute("curve", "c1x", 0.0, j), xmlDoc.getAttribute("curve", "c1y", 0.0, j));
+				ofPoint control2(xmlDoc.getAttribute("curve", "c2x", 0.0, j), xmlDoc.getAttribute("curve", "c2y", 0.0, j));
+				ofPoint end(xmlDoc.getAttribute("curve", "x", 0.0, j), xmlDoc.getAttribute("curve", "y", 0.0, j));
+
+				shapes[i].addSegment(control1, control2, end);
+			}
+
+			xmlDoc.popTag();
+			xmlDoc.popTag();
+		}
+
+		xmlDoc.popTag();
+
+		return true;
+	}
+};
@@ -0,0 +1,196 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "BezierShape.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// turns a shape's outline into smooth bezier curves
+// first it removes points that are on the same slope, then it creates a curve thru each remaining point
+// the math is done on flat arrays of floats so the compiler (and SSE) can work on several points at once
+// each smoother keeps its own scratch arrays, so use one per thread
+
+class BezierSmoother {
+
+public:
+
+	//--------------------------------------------------------------
+
+	BezierSmoother(){
+
+		smoothValue = 1.5;
+		decimationStep = 5;
+	}
+
+	//--------------------------------------------------------------
+
+	// create a new set of points, removing points on the same slope
+	// don't read every point .. increment by the decimation step
+
+	void decimate(const vector<ofPoint> & points, vector<ofPoint> & newPoints){
+
+		newPoints.clear();
+
+		if( points.size() == 0 ) return;
+
+		newPoints.push_back(points[0]);
+
+		int reach = decimationStep - 1;
+
+		for( int p = decimationStep; p + reach < points.size(); p += decimationStep){
+
+			float curSlope = 0;
+			float lastSlope = 0;
+
+			ofPoint d1 = points[p+reach]-points[p];
+			ofPoint d2 = points[p]-points[p-reach];
+
+			if( d1.x != 0 ) curSlope = d1.y/d1.x;
+			if( d2.x != 0 ) lastSlope = d2.y/d2.x;
+
+			if( curSlope != lastSlope ){
+
+				newPoints.push_back(points[p]);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// create a closed, smoothed bezier shape from an outline
+
+	void smooth(const vector<ofPoint> & points, BezierShape & shape){
+
+		shape.clear();
+
+		decimate(points, newPoints);
+
+		int numPoints = newPoints.size();
+
+		if( numPoints == 0 ) return;
+
+		shape.start = newPoints[0];
+
+		// not enough points to curve, just connect them
+		if( numPoints < 4 ){
+
+			for(int i=1; i<=numPoints; i++){
+
+				ofPoint & end = newPoints[i % numPoints];
+				shape.addSegment(end, end, end);
+			}
+
+			return;
+		}
+
+		// copy the points into flat arrays, shifted by one & wrapped around at the end
+		// so x[i], x[i+1], x[i+2], x[i+3] are the points before, at, after & two after point i
+		int numPadded = numPoints + 3;
+
+		x.resize(numPadded);
+		y.resize(numPadded);
+
+		for(int k=0; k<numPadded; k++){
+
+			ofPoint & pt = newPoints[(k + numPoints - 1) % numPoints];
+			x[k] = pt.x;
+			y[k] = pt.y;
+		}
+
+		// the midpoint & length of each edge (from point k to point k+1)
+		int numEdges = numPadded - 1;
+
+		midX.resize(numEdges);
+		midY.resize(numEdges);
+		lengths.resize(numEdges);
+
+		for(int k=0; k<numEdges; k++){
+
+			float dx = x[k+1] - x[k];
+			float dy = y[k+1] - y[k];
+
+			midX[k] = (x[k] + x[k+1]) * 0.5f;
+			midY[k] = (y[k] + y[k+1]) * 0.5f;
+			lengths[k] = dx * dx + dy * dy;
+		}
+
+		// one square root per edge (each edge length is shared by three curves)
+		squareRoots(&lengths[0], numEdges);
+
+		// the control points for the curve from point i to point i+1
+		// (no branches in this loop so it can be vectorized)
+		ctrl1X.resize(numPoints);
+		ctrl1Y.resize(numPoints);
+		ctrl2X.resize(numPoints);
+		ctrl2Y.resize(numPoints);
+
+		float smooth = smoothValue;
+
+		for(int i=0; i<numPoints; i++){
+
+			float len1 = lengths[i];
+			float len2 = lengths[i+1];
+			float len3 = lengths[i+2];
+
+			float k1 = len1 / (len1 + len2 + 1e-6f);
+			float k2 = len2 / (len2 + len3 + 1e-6f);
+
+			float xm1 = midX[i] + (midX[i+1] - midX[i]) * k1;
+			float ym1 = midY[i] + (midY[i+1] - midY[i]) * k1;
+
+			float xm2 = midX[i+1] + (midX[i+2] - midX[i+1]) * k2;
+			float ym2 = midY[i+1] + (midY[i+2] - midY[i+1]) * k2;
+
+			// resulting control points, pulled towards the middle of the edge by the smoothing coefficient
+			ctrl1X[i] = xm1 + (midX[i+1] - xm1) * smooth + x[i+1] - xm1;
+			ctrl1Y[i] = ym1 + (midY[i+1] - ym1) * smooth + y[i+1] - ym1;
+
+			ctrl2X[i] = xm2 + (midX[i+1] - xm2) * smooth + x[i+2] - xm2;
+			ctrl2Y[i] = ym2 + (midY[i+1] - ym2) * smooth + y[i+2] - ym2;
+		}
+
+		// create a bezier curve to each next point
+		shape.segments.resize(numPoints);
+
+		for(int i=0; i<numPoints; i++){
+
+			BezierSegment & segment = shape.segments[i];
+			segment.control1.set(ctrl1X[i], ctrl1Y[i]);
+			segment.control2.set(ctrl2X[i], ctrl2Y[i]);
+			segment.end.set(x[i+2], y[i+2]);
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// replace each value with its square root, four at a time when we can
+
+	static void squareRoots(float * values, int count){
+
+		int i = 0;
+
+#ifdef __SSE__
+		for( ; i + 4 <= count; i += 4){
+
+			_mm_storeu_ps(values + i, _mm_sqrt_ps(_mm_loadu_ps(values + i)));
+		}
+#endif
+
+		for( ; i < count; i++){
+
+			values[i] = sqrtf(values[i]);
+		}
+	}
+
+	float smoothValue; // smoothing coefficient
+	int decimationStep;
+
+	// scratch space, reused from shape to shape
+	vector<ofPoint> newPoints;
+	vector<float> x, y;
+	vector<float> midX, midY, lengths;
+	vector<float> ctrl1X, ctrl1Y, ctrl2X, ctrl2Y;
+};
@@ -0,0 +1,314 @@
+
+#pragma once
+
+#include "ofMain.h"
+#include "BezierShape.h"
+
+// fits as few bezier curves as possible to an outline, keeping within an error distance
+// based on Philip J. Schneider's "An Algorithm for Automatically Fitting Digitized Curves" (Graphics Gems, 1990)
+// a curve is fit to the points with least squares, if it's too far from any point
+// we try to nudge the curve's parameters a few times, and if that fails we split the points in two & fit each half
+
+class CurveFitter {
+
+public:
+
+	//--------------------------------------------------------------
+
+	CurveFitter(){
+
+		maxError = 2.0;
+		maxIterations = 4;
+	}
+
+	//--------------------------------------------------------------
+
+	// fit a closed outline
+
+	void fit(const vector<ofPoint> & points, BezierShape & shape){
+
+		shape.clear();
+
+		// remove repeated points, they break the tangents & parameters
+		pts.clear();
+
+		for(int i=0; i<points.size(); i++){
+
+			if( pts.size() == 0 || points[i] != pts.back() ){
+
+				pts.push_back(points[i]);
+			}
+		}
+
+		while( pts.size() > 1 && pts.back() == pts[0] ) pts.pop_back();
+
+		if( pts.size() == 0 ) return;
+
+		shape.start = pts[0];
+
+		// not enough points to curve, just connect them
+		if( pts.size() < 4 ){
+
+			for(int i=1; i<=pts.size(); i++){
+
+				ofPoint & end = pts[i % pts.size()];
+				shape.addSegment(end, end, end);
+			}
+
+			return;
+		}
+
+		// close the outline by ending on the first point
+		// & use the same tangent on both sides of the join so it's smooth
+		pts.push_back(pts[0]);
+
+		int last = pts.size() - 1;
+		ofPoint tangent = normalize(pts[1] - pts[last-1], pts[1] - pts[0]);
+
+		fitCubic(0, last, tangent, tangent * -1, shape);
+	}
+
+	//--------------------------------------------------------------
+
+	// fit a curve to the points from first to last
+	// tangent1 points forward from the first point, tangent2 points backward from the last point
+
+	void fitCubic(int first, int last, ofPoint tangent1, ofPoint tangent2, BezierShape & shape){
+
+		int numPts = last - first + 1;
+
+		// just two points, use a heuristic
+		if( numPts == 2 ){
+
+			float dist = pts[first].distance(pts[last]) / 3.0;
+			shape.addSegment(pts[first] + tangent1 * dist, pts[last] + tangent2 * dist, pts[last]);
+			return;
+		}
+
+		// parameterize the points & try to fit a curve
+		vector<float> u;
+		chordLengthParameterize(first, last, u);
+
+		ofPoint curve[4];
+		generateBezier(first, last, u, tangent1, tangent2, curve);
+
+		int splitPoint;
+		float errorSq = maxError * maxError;
+		float worstErrorSq = computeMaxError(first, last, curve, u, splitPoint);
+
+		if( worstErrorSq < errorSq ){
+
+			shape.addSegment(curve[1], curve[2], curve[3]);
+			return;
+		}
+
+		// if the error isn't too large, try some reparameterization & refitting
+		if( worstErrorSq < errorSq * 16 ){
+
+			for(int i=0; i<maxIterations; i++){
+
+				reparameterize(first, last, u, curve);
+				generateBezier(first, last, u, tangent1, tangent2, curve);
+				worstErrorSq = computeMaxError(first, last, curve, u, splitPoint);
+
+				if( worstErrorSq < errorSq ){
+
+					shape.addSegment(curve[1], curve[2], curve[3]);
+					return;
+				}
+			}
+		}
+
+		// fitting failed, split at the point of max error & fit each part recursively
+		ofPoint centerTangent = normalize(pts[splitPoint-1] - pts[splitPoint+1], pts[splitPoint-1] - pts[splitPoint]);
+
+		fitCubic(first, splitPoint, tangent1, centerTangent, shape);
+		fitCubic(splitPoint, last, centerTangent * -1, tangent2, shape);
+	}
+
+	//--------------------------------------------------------------
+
+	// use least-squares to find the bezier control points for a region
+	// the end points are fixed, only the distance of the control points along the tangents is solved for
+
+	void generateBezier(int first, int last, vector<float> & u, ofPoint & tangent1, ofPoint & tangent2, ofPoint * curve){
+
+		int numPts = last - first + 1;
+
+		ofPoint & firstPt = pts[first];
+		ofPoint & lastPt = pts[last];
+
+		float c00 = 0, c01 = 0, c11 = 0;
+		float x0 = 0, x1 = 0;
+
+		for(int i=0; i<numPts; i++){
+
+			float b0, b1, b2, b3;
+			bernstein(u[i], b0, b1, b2, b3);
+
+			ofPoint a0 = tangent1 * b1;
+			ofPoint a1 = tangent2 * b2;
+
+			c00 += a0.dot(a0);
+			c01 += a0.dot(a1);
+			c11 += a1.dot(a1);
+
+			ofPoint tmp = pts[first + i] - (firstPt * (b0 + b1) + lastPt * (b2 + b3));
+
+			x0 += a0.dot(tmp);
+			x1 += a1.dot(tmp);
+		}
+
+		// compute the determinants of C and X
+		float detC0C1 = c00 * c11 - c01 * c01;
+		float detC0X = c00 * x1 - c01 * x0;
+		float detXC1 = x0 * c11 - x1 * c01;
+
+		// finally, derive the alpha values
+		float alpha1 = ( detC0C1 == 0 ) ? 0 : detXC1 / detC0C1;
+		float alpha2 = ( detC0C1 == 0 ) ? 0 : detC0X / detC0C1;
+
+		// if alpha is negative or tiny, fall back on the heuristic
+		float segLength = firstPt.distance(lastPt);
+		float epsilon = 1.0e-6 * segLength;
+
+		if( alpha1 < epsilon || alpha2 < epsilon ){
+
+			alpha1 = alpha2 = segLength / 3.0;
+		}
+
+		// the control points are on the tangent vectors, alpha away from the ends
+		curve[0] = firstPt;
+		curve[1] = firstPt + tangent1 * alpha1;
+		curve[2] = lastPt + tangent2 * alpha2;
+		curve[3] = lastPt;
+	}
+
+	//--------------------------------------------------------------
+
+	// improve the parameter of each point with one step of Newton-Raphson
+
+	void reparameterize(int first, int last, vector<float> & u, ofPoint * curve){
+
+		for(int i=first; i<=last; i++){
+
+			u[i-first] = newtonRaphsonRootFind(curve, pts[i], u[i-first]);
+		}
+	}
+
+	float newtonRaphsonRootFind(ofPoint * q, ofPoint & p, float u){
+
+		// Q(u), Q'(u) and Q''(u)
+		ofPoint q1[3], q2[2];
+
+		for(int i=0; i<3; i++) q1[i] = (q[i+1] - q[i]) * 3.0;
+		for(int i=0; i<2; i++) q2[i] = (q1[i+1] - q1[i]) * 2.0;
+
+		ofPoint qU = evaluate(3, q, u);
+		ofPoint q1U = evaluate(2, q1, u);
+		ofPoint q2U = evaluate(1, q2, u);
+
+		float numerator = (qU - p).dot(q1U);
+		float denominator = q1U.dot(q1U) + (qU - p).dot(q2U);
+
+		if( denominator == 0 ) return u;
+
+		return u - numerator / denominator;
+	}
+
+	//--------------------------------------------------------------
+
+	// evaluate a bezier curve of any degree at a parameter
+
+	ofPoint evaluate(int degree, ofPoint * v, float t){
+
+		ofPoint temp[4];
+
+		for(int i=0; i<=degree; i++) temp[i] = v[i];
+
+		// triangle computation
+		for(int i=1; i<=degree; i++){
+
+			for(int j=0; j<=degree-i; j++){
+
+				temp[j] = temp[j] * (1.0 - t) + temp[j+1] * t;
+			}
+		}
+
+		return temp[0];
+	}
+
+	//--------------------------------------------------------------
+
+	void bernstein(float u, float & b0, float & b1, float & b2, float & b3){
+
+		float mu = 1.0 - u;
+
+		b0 = mu * mu * mu;
+		b1 = 3 * u * mu * mu;
+		b2 = 3 * u * u * mu;
+		b3 = u * u * u;
+	}
+
+	//--------------------------------------------------------------
+
+	// give each point a parameter from 0 to 1 based on its distance along the outline
+
+	void chordLengthParameterize(int first, int last, vector<float> & u){
+
+		u.resize(last - first + 1);
+		u[0] = 0;
+
+		for(int i=first+1; i<=last; i++){
+
+			u[i-first] = u[i-first-1] + pts[i].distance(pts[i-1]);
+		}
+
+		float total = u[last-first];
+
+		for(int i=first+1; i<=last; i++){
+
+			u[i-first] = ( total > 0 ) ? u[i-first] / total : 0;
+		}
+	}
+
+	//--------------------------------------------------------------
+
+	// find the point furthest from the curve, returns the squared distance
+
+	float computeMaxError(int first, int last, ofPoint * curve, vector<float> & u, int & splitPoint){
+
+		splitPoint = (last - first + 1) / 2 + first;
+
+		float maxDist = 0;
+
+		for(int i=first+1; i<last; i++){
+
+			float dist = evaluate(3, curve, u[i-first]).squareDistance(pts[i]);
+
+			if( dist >= maxDist ){
+
+				maxDist = dist;
+				splitPoint = i;
+			}
+		}
+
+		return maxDist;
+	}
+
+	//--------------------------------------------------------------
+
+	// normalize a vector, falling back on a second one if it has no length
+
+	ofPoint normalize(ofPoint v, ofPoint fallback){
+
+		if( v.length() == 0 ) v = fallback;
+
+		return v.getNormalized();
+	}
+
+	float maxError; // how far (in pixels) the curves can be from the points
+	int maxIterations;
+
+	vector<ofPoint> pts;
+};
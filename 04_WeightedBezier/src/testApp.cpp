@@ -10,14 +10,31 @@ void testApp::setup(){
 	// load the path
 	loadShape("shapes.xml", originalPath);
 	
+	// smooth the points (or fit as few curves as we can to them)
+	bFitCurves = false;
+	
 	// create a bezier-interpolated copy of that path
-	interpolateShape(originalPath, interpolatedPath);
+	interpolateShape(originalPath, interpolatedShapes);
+	
+	// how big to draw the smoothed shape, and whether to draw lots of tiny copies of it
+	drawScale = 1.0;
+	bDrawCrowd = false;
+	
+	bBatchRunning = false;
 }
 
 //--------------------------------------------------------------
 
 void testApp::update(){
 
+	// check if the batch of frames is done
+	if( bBatchRunning && batchSmoother.isFinished() ){
+		
+		batchSmoother.stop();
+		bBatchRunning = false;
+		
+		ofLogNotice("Finished smoothing "+ofToString(batchSmoother.getNumFiles())+" frames");
+	}
 }
 
 //--------------------------------------------------------------
@@ -27,7 +44,46 @@ void testApp::draw(){
 	
 	originalPath.draw(0, 0);
 	
-	interpolatedPath.draw(ofGetWidth()/2, 0);
+	// draw the smoothed shape
+	// each shape picks the level of detail that looks right at the scale it's drawn at
+	int numPointsDrawn = 0;
+	int level = 0;
+	
+	for(int i=0; i<interpolatedShapes.size(); i++){
+		
+		if( bDrawCrowd ){
+			
+			// a crowd of small, far away copies
+			for(int y=0; y<32; y++){
+				
+				for(int x=0; x<32; x++){
+					
+					numPointsDrawn += interpolatedShapes[i].draw(ofGetWidth()/2 + x * ofGetWidth()/64, y * ofGetHeight()/32, drawScale / 32);
+				}
+			}
+			
+		} else {
+			
+			numPointsDrawn += interpolatedShapes[i].draw(ofGetWidth()/2, 0, drawScale);
+		}
+		
+		level = interpolatedShapes[i].lastLevelDrawn;
+	}
+	
+	ofSetColor(0, 255, 255);
+	ofDrawBitmapString("Scale "+ofToString(drawScale, 2)+", detail level "+ofToString(level)+", "+ofToString(numPointsDrawn)+" points drawn", ofGetWidth()/2+20, ofGetHeight()-40);
+	ofDrawBitmapString("Press +/- to scale, 'c' to draw a crowd of copies", ofGetWidth()/2+20, ofGetHeight()-60);
+	ofDrawBitmapString(ofToString(numOriginalPoints)+" points", 20, ofGetHeight()-20);
+	ofDrawBitmapString(ofToString(numCurves)+(bFitCurves ? " fitted curves" : " smoothed curves")+" (press 'f' to switch)", ofGetWidth()/2+20, ofGetHeight()-20);
+	
+	if( bBatchRunning ){
+		
+		ofDrawBitmapString("Smoothing frame "+ofToString(batchSmoother.getNumFinished())+"/"+ofToString(batchSmoother.getNumFiles()), 20, 20);
+		
+	} else {
+		
+		ofDrawBitmapString("Press 'b' to smooth every shape in the frames folder", 20, 20);
+	}
 }
 
 //--------------------------------------------------------------
@@ -89,99 +145,32 @@ void testApp::loadShape(string url, ofPath & path){
 //--------------------------------------------------------------
 
 // create a new smoothed shape from the original shape we loaded
+// each contour in the path is smoothed into a new bezier shape
 
-void testApp::interpolateShape(ofPath & path, ofPath & newpath){
+void testApp::interpolateShape(ofPath & path, vector<BezierShape> & newShapes){
 	
-	newpath.clear(); // clear any points in the new shape 
+	vector<ofPolyline> & contours = path.getOutline();
 	
-	vector<ofPolyline> contours = path.getOutline();
+	newShapes.resize(contours.size());
 	
-	if( contours.size() > 0 ){
-		
-		// just look at the first subpath (assume we just have one)
-		
-		vector<ofPoint> points = contours[0].getVertices();
-		vector<ofPoint> newPoints;
-		
-		// create a new set of contours, removing points on the same slope
-		// don't read every point .. increment by 5
-		
-		newPoints.push_back(points[0]);
-		
-		for( int p = 5; p < points.size()-1; p+=5){
-			
-			float curSlope = 0;
-			float lastSlope = 0;
-			
-			ofPoint d1 = points[p+4]-points[p];
-			ofPoint d2 = points[p]-points[p-4];
-			
-			if( d1.x != 0 ) curSlope = d1.y/d1.x;
-			if( d2.x != 0 ) lastSlope = d2.y/d2.x;
-			
-			if( curSlope != lastSlope ){ 
-				
-				newPoints.push_back(points[p]);
-			}
-		}
-		
-		int numPoints = newPoints.size() -1;
-		
-		// add the first point
-		newpath.moveTo(newPoints[0]);
-		
-		float smooth_value = 1.5; // smoothing coefficient
+	numOriginalPoints = 0;
+	numCurves = 0;
+	
+	for(int i=0; i<contours.size(); i++){
 		
-		for( int i=1; i<numPoints; i++){
-			
-			int p0 = i-1;
-			int p1 = i;
-			int p2 = i+1;
-			int p3 = i+2;
-			
-			if( p0 < 0) p0 += numPoints+1;
-			if( p0 > numPoints ) p0 %= numPoints+1;
-			if( p1 < 0) p1 += numPoints+1;
-			if( p1 > numPoints ) p1 %= numPoints+1;
-			if( p2 > numPoints ) p2 %= numPoints+1;
-			if( p2 < 0) p2 += numPoints+1;
-			if( p3 > numPoints ) p3 %= numPoints+1;
-			
-			float xc1 = (newPoints[p0].x + newPoints[p1].x) / 2.0;
-			float yc1 = (newPoints[p0].y + newPoints[p1].y) / 2.0;
-			float xc2 = (newPoints[p1].x + newPoints[p2].x) / 2.0;
-			float yc2 = (newPoints[p1].y + newPoints[p2].y) / 2.0;
-			float xc3 = (newPoints[p2].x + newPoints[p3].x) / 2.0;
-			float yc3 = (newPoints[p2].y + newPoints[p3].y) / 2.0;
+		if( bFitCurves ){
 			
-			float len1 = sqrt((newPoints[p1].x-newPoints[p0].x) * (newPoints[p1].x-newPoints[p0].x) + (newPoints[p1].y-newPoints[p0].y) * (newPoints[p1].y-newPoints[p0].y));
-			float len2 = sqrt((newPoints[p2].x-newPoints[p1].x) * (newPoints[p2].x-newPoints[p1].x) + (newPoints[p2].y-newPoints[p1].y) * (newPoints[p2].y-newPoints[p1].y));
-			float len3 = sqrt((newPoints[p3].x-newPoints[p2].x) * (newPoints[p3].x-newPoints[p2].x) + (newPoints[p3].y-newPoints[p2].y) * (newPoints[p3].y-newPoints[p2].y));
+			fitter.fit(contours[i].getVertices(), newShapes[i]);
 			
-			float k1 = len1 / (len1 + len2);
-			float k2 = len2 / (len2 + len3);
+		} else {
 			
-			float xm1 = xc1 + (xc2 - xc1) * k1;
-			float ym1 = yc1 + (yc2 - yc1) * k1;
-			
-			float xm2 = xc2 + (xc3 - xc2) * k2;
-			float ym2 = yc2 + (yc3 - yc2) * k2;
-			
-			// Resulting control points. Here smooth_value is mentioned
-			// above coefficient K (smooth_value) whose value should be in range [0...1].
-			float ctrl1_x = xm1 + (xc2 - xm1) * smooth_value + newPoints[p1].x - xm1;
-			float ctrl1_y = ym1 + (yc2 - ym1) * smooth_value + newPoints[p1].y - ym1;
-			
-			float ctrl2_x = xm2 + (xc2 - xm2) * smooth_value + newPoints[p2].x - xm2;
-			float ctrl2_y = ym2 + (yc2 - ym2) * smooth_value + newPoints[p2].y - ym2;
-			
-			// create a bezier curve to the next point
-			newpath.bezierTo(ofPoint(ctrl1_x, ctrl1_y), ofPoint(ctrl2_x, ctrl2_y), newPoints[p2]);
+			smoother.smooth(contours[i].getVertices(), newShapes[i]);
 		}
 		
-		newpath.close();
+		newShapes[i].color = path.getFillColor();
 		
-		newpath.setColor(path.getFillColor());
+		numOriginalPoints += contours[i].size();
+		numCurves += newShapes[i].segments.size();
 	}
 }
 
@@ -189,6 +178,30 @@ void testApp::interpolateShape(ofPath & path, ofPath & newpath){
 
 void testApp::keyPressed(int key){
 
+	if( key == 'b' && !bBatchRunning ){
+		
+		// smooth all of the shapes saved by the tracking apps
+		batchSmoother.start("frames", "smoothed", bFitCurves);
+		bBatchRunning = true;
+		
+	} else if( key == 'f' ){
+		
+		// switch between smoothing & curve fitting
+		bFitCurves = !bFitCurves;
+		interpolateShape(originalPath, interpolatedShapes);
+		
+	} else if( key == '+' || key == '=' ){
+		
+		drawScale *= 1.25;
+		
+	} else if( key == '-' ){
+		
+		drawScale /= 1.25;
+		
+	} else if( key == 'c' ){
+		
+		bDrawCrowd = !bDrawCrowd;
+	}
 }
 
 //--------------------------------------------------------------
@@ -11,6 +11,9 @@ September 2012
 
 #include "ofMain.h"
 #include "ofxXmlSettings.h"
+#include "BezierSmoother.h"
+#include "CurveFitter.h"
+#include "BatchSmoother.h"
 
 class testApp : public ofBaseApp{
 	
@@ -21,7 +24,7 @@ public:
 	void draw();
 	
 	void loadShape(string url, ofPath & path);
-	void interpolateShape(ofPath & path, ofPath & newpath);
+	void interpolateShape(ofPath & path, vector<BezierShape> & newShapes);
 	
 	void keyPressed(int key);
 	void keyReleased(int key);
@@ -31,5 +34,17 @@ public:
 	void mouseReleased(int x, int y, int button);
 	
 	ofPath originalPath;
-	ofPath interpolatedPath;
+	vector<BezierShape> interpolatedShapes;
+	
+	BezierSmoother smoother;
+	CurveFitter fitter;
+	bool bFitCurves;
+	int numOriginalPoints;
+	int numCurves;
+	
+	float drawScale;
+	bool bDrawCrowd;
+	
+	BatchSmoother batchSmoother;
+	bool bBatchRunning;
 };